@@ -1,37 +1,78 @@
+#ifndef MATCH_SIM_K_H
+#define MATCH_SIM_K_H
+
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "utils/Common.h"
+#include "utils/Fingerprint.h"
 
 using namespace std;
 
+class TextIndex;
+struct ShortlexResult;
+struct ShortlexWorkspace;
+
 namespace MatchSimK {
     using triple = tuple<Interval, Interval, int>;  // ([f_1, f_2], [b_1, b_2], offset)
 
     vector<triple> matchSimK(const string& text, const string& pattern, int k);
 
+    // Same as above, on a prebuilt index of T. alph(p) must equal the indexed alphabet (std::invalid_argument otherwise).
+    vector<triple> matchSimK(const TextIndex& index, const string& pattern, int k);
+
     struct CheckPoint {
         Interval link;
         std::string partial_shortlex;
+        Fingerprint fingerprint;  // of partial_shortlex
         std::vector<int> x_vector, y_vector;
 
         CheckPoint() {};
 
         // This constructor is for saving XY-link
-        CheckPoint(Interval link, std::string partial_shortlex)
-            : link(link), partial_shortlex(partial_shortlex) {};
+        CheckPoint(Interval link, std::string partial_shortlex, Fingerprint fingerprint)
+            : link(link), partial_shortlex(partial_shortlex), fingerprint(fingerprint) {};
 
         // This constructor is for saving YX-link
-        CheckPoint(Interval link, std::string partial_shortlex, std::vector<int> x_vector, std::vector<int> y_vector)
-            : link(link), partial_shortlex(partial_shortlex), x_vector(x_vector), y_vector(y_vector) {};
+        CheckPoint(Interval link,
+            std::string partial_shortlex,
+            Fingerprint fingerprint,
+            std::vector<int> x_vector,
+            std::vector<int> y_vector)
+            : link(link),
+              partial_shortlex(partial_shortlex),
+              fingerprint(fingerprint),
+              x_vector(x_vector),
+              y_vector(y_vector) {};
     };
 
+    // Lines 21-22: finds or computes (and saves) the checkpoint of every link of T'[j_2 : j_1], in the order z is
+    // made of: YX-link 0, XY-link 0, YX-link 1, ..., YX-link ι(p). The pointers stay valid until check_points grows.
+    vector<const CheckPoint*> link_checkpoints(
+        int k,
+        int pattern_universality,
+        const string& sub_T_string,
+        vector<vector<MatchSimK::CheckPoint>>& check_points,
+        const vector<int>& x_arch_indexes,
+        const vector<int>& y_arch_indexes,
+        ShortlexWorkspace& workspace  // scratch space of the shortlex kernel, reused across calls
+    );
+
+    // Line 23: z == ShortLex_k(p) for z made of the given checkpoints. Combines their fingerprints first, and
+    // compares the pieces with the normal form of p only if the fingerprints match.
+    bool matches_shortlex(const vector<const CheckPoint*>& z_pieces, const ShortlexResult& shortlex_p);
+
+    // z itself, i.e. the partial normal forms of link_checkpoints(...) concatenated
     string shortlex_with_checkpoint(
         int k,
         int pattern_universality,
         const string& sub_T_string,
         vector<vector<MatchSimK::CheckPoint>>& check_points,
         const vector<int>& x_arch_indexes,
-        const vector<int>& y_arch_indexes
+        const vector<int>& y_arch_indexes,
+        ShortlexWorkspace& workspace
     );
-}  // namespace MatchSimK
\ No newline at end of file
+}  // namespace MatchSimK
+
+#endif  // MATCH_SIM_K_H
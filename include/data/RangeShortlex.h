@@ -0,0 +1,46 @@
+#ifndef RANGE_SHORTLEX_H
+#define RANGE_SHORTLEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "data/Shortlex.h"
+
+using namespace std;
+
+/**
+ * k-SNF of arbitrary factors text[begin, end) of a fixed text.
+ *
+ * ~k is a congruence, so SNF(uv) = SNF(SNF(u) SNF(v)): the text is cut into blocks of BLOCK letters, and a
+ * bottom-up segment tree over the blocks stores the normal form of every node's range. A query concatenates the
+ * letters of the two partial end blocks and the normal forms of the O(log n) nodes covering the rest, and
+ * normalizes that once. Normal forms do not grow with the range, so a query costs O(log n) normal forms instead
+ * of a pass over the whole factor. Letters must be in the alphabet set when the index was built.
+ */
+class RangeShortlex {
+   public:
+    static constexpr int BLOCK = 64;
+
+    RangeShortlex(string text, int k);
+
+    int size() const { return text.size(); }
+
+    // k-SNF of text[begin, end). Throws std::out_of_range unless 0 <= begin <= end <= size().
+    const string &normalForm(int begin, int end);
+
+   private:
+    string text;
+    int k;
+
+    // nodes[blocks + i] is the normal form of block i, nodes[i] that of nodes[2i] nodes[2i+1]
+    int blocks;
+    vector<string> nodes;
+
+    ShortlexWorkspace workspace;
+    string scratch;
+    vector<int> rightNodes;  // covering nodes of a query right of the middle, right to left
+    string current;
+};
+
+#endif  // RANGE_SHORTLEX_H
@@ -1,24 +1,143 @@
 #ifndef RANKER_H
 #define RANKER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+#include "utils/SymbolMask.h"
+
 class RankerTable {
    public:
-    RankerTable(const std::string &text);
+    // How ranks are stored.
+    //   Table:      (n+1) x sigma cells per direction, O(1) lookups
+    //   Occurrence: sorted occurrence list per char, O(n) space, O(log n) lookups
+    //   Auto:       Table unless its footprint would exceed AUTO_TABLE_LIMIT bytes
+    enum class Backend { Auto, Table, Occurrence };
+
+    static constexpr size_t AUTO_TABLE_LIMIT = size_t(1) << 30;
+
+    RankerTable(const std::string &text, Backend backend = Backend::Auto);
+
+    // Wraps prebuilt uint32_t cells (e.g. memory-mapped from a TextIndex) without copying them.
+    // The cells must outlive the table, and the table must not be rebuilt.
+    RankerTable(const std::string &text, const uint32_t *xCells, const uint32_t *yCells);
 
-    void buildXRankerTable();
-    void buildYRankerTable();
+    RankerTable(const RankerTable &other);
+    RankerTable &operator=(const RankerTable &other);
+    RankerTable(RankerTable &&other) = default;
+    RankerTable &operator=(RankerTable &&other) = default;
+
+    // Builds one direction with `threads` threads (0 = hardware concurrency). The text is split into
+    // contiguous chunks scanned independently; cells left INF / -1 at chunk edges are then filled from
+    // the neighbouring chunks' boundary vectors. The result is identical to the serial build.
+    void buildXRankerTable(int threads = 1);
+    void buildYRankerTable(int threads = 1);
+
+    // Builds X and Y concurrently, splitting `threads` between the two directions
+    void buildRankerTables(int threads = 0);
 
     int getX(int index, char c) const;
     int getY(int index, char c) const;
 
+    // Same as getX/getY, with a dense alphabet index instead of a char
+    int getXByIndex(int index, int charIndex) const;
+    int getYByIndex(int index, int charIndex) const;
+
+    // Batched queries over the chars in `symbols` at one position, without per-char alphabet lookups.
+    // With the full alphabet they reduce one contiguous row. An empty mask gives -1 for max and INF for min.
+    int maxX(int index, const SymbolMask &symbols) const;
+    int minX(int index, const SymbolMask &symbols) const;
+    int maxY(int index, const SymbolMask &symbols) const;
+    int minY(int index, const SymbolMask &symbols) const;
+
+    // Ranks of the chars in `symbols` at one position, in ascending index order
+    void gatherX(int index, const SymbolMask &symbols, int *out) const;
+    void gatherY(int index, const SymbolMask &symbols, int *out) const;
+
+    // maxX / minY for every position in [begin, end), written to out[0, end - begin)
+    void maxX(int begin, int end, const SymbolMask &symbols, int *out) const;
+    void minY(int begin, int end, const SymbolMask &symbols, int *out) const;
+
+    // Appends chars to the text. Each char adds one Y-row in O(sigma) and one all-INF X-row.
+    // X-cells of earlier rows whose next occurrence of the char was INF are not rewritten here:
+    // getX resolves them from the pending appends until flushPendingX() patches them in place.
+    // Cells that already hold a rank are never rewritten. Not supported on external cells.
+    void append(char c);
+    void append(const std::string &chunk);
+
+    // Patches every X-cell left pending by append(), touching each such cell exactly once
+    void flushPendingX();
+
+    int length() const { return text.size(); }
+
+    // Bytes held by the X- and Y-ranker tables
+    size_t memoryUsage() const;
+
+    // Copies `count` cells of the flat buffers starting at cell `from` (= index * sigma + charIndex) to `out`, in
+    // the uint32_t encoding taken by the external-cells constructor. Table backend only, with no pending X-cells.
+    void copyXCells(size_t from, size_t count, uint32_t *out) const;
+    void copyYCells(size_t from, size_t count, uint32_t *out) const;
+
+    // true if cells are stored as uint16_t, false if uint32_t
+    bool isNarrow() const { return narrow; }
+
+    Backend getBackend() const { return backend; }
+
    private:
     std::string text;
-    std::vector<std::vector<int>> xTable;  // [index][char]
-    std::vector<std::vector<int>> yTable;  // [index][char]
+    Backend backend;  // never Auto once constructed
+    int width;        // cells per row (= alphabet size)
+    bool narrow;      // chosen at construction: uint16_t cells whenever every rank of the text fits
+    SymbolMask allSymbols;
+
+    // Both tables are a single row-major buffer: cell [index * width + charIndex].
+    // X-cells hold the rank itself with INF encoded as the largest cell value,
+    // Y-cells hold rank + 1 so that -1 is encoded as 0.
+    // Only the pair matching `narrow` is allocated, and only for the Table backend.
+    std::vector<uint16_t> xTable16;
+    std::vector<uint16_t> yTable16;
+    std::vector<uint32_t> xTable32;
+    std::vector<uint32_t> yTable32;
+
+    // Cells read by getX/getY: the owned tables above, or external cells
+    const void *xCells = nullptr;
+    const void *yCells = nullptr;
+
+    // Occurrence backend: ascending positions of each char, shared by both directions
+    std::vector<std::vector<int>> occurrences;  // [charIndex][k]
+    bool occurrencesBuilt = false;
+
+    // Lazy X-patching after append() (Table backend, once the X-ranker is built).
+    // Rows [xPatchFrom[c], n] have INF for c; pendingX[c] lists appended positions of c not yet patched in.
+    bool xBuilt = false;
+    std::vector<int> xPatchFrom;            // [charIndex]
+    std::vector<std::vector<int>> pendingX;  // [charIndex][k], ascending
+    size_t pendingXCount = 0;
+
+    template <typename Cell>
+    void appendRows(std::vector<Cell> &xTable, std::vector<Cell> &yTable, int charIndex);
+
+    template <typename Cell>
+    void patchX(std::vector<Cell> &xTable);
+
+    void widen();
+
+    template <bool IsMax>
+    int reduceX(int index, const SymbolMask &symbols) const;
+
+    template <bool IsMax>
+    int reduceY(int index, const SymbolMask &symbols) const;
+
+    void buildOccurrences();
+    void pointAtOwnedTables();
+
+    template <typename Cell>
+    void fillXRows(std::vector<Cell> &table, int threads);
+
+    template <typename Cell>
+    void fillYRows(std::vector<Cell> &table, int threads);
 };
 
 #endif  // RANKER_H
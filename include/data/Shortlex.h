@@ -1,28 +1,100 @@
+#ifndef SHORTLEX_H
+#define SHORTLEX_H
+
 #include <algorithm>
+#include <array>
 #include <deque>
 #include <limits>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "utils/Fingerprint.h"
+#include "utils/SymbolMask.h"
+
 using namespace std;
 
 // Structure to hold the result: the shortlex normal form and its corresponding
 // X- and Y-vectors.
 struct ShortlexResult {
     string shortlexNormalForm;
+    Fingerprint fingerprint;  // of shortlexNormalForm
     vector<int> X_vector;
     vector<int> Y_vector;
 
     deque<set<char>> stackForm;
+    vector<SymbolMask> stackMasks;  // stackForm as dense alphabet index masks, top of the stack at the back
     vector<int> arch_ends;
     set<char> alphabet;
     int universality;
 };
 
+// Caller-owned scratch space of the shortlex kernels below. Buffers only grow, so once a workspace has seen
+// the longest input and the largest alphabet, kernel calls on it no longer allocate.
+struct ShortlexWorkspace {
+    vector<int> X;        // [i] X-coordinate of w[i]
+    vector<int> normalX;  // [j] coordinates of the kept letters, aligned with `buffer`
+    vector<int> normalY;
+    vector<int> xVector;  // [charIndex] the new X-vector at the end
+    vector<int> yVector;  // [charIndex] the new Y-vector at the end
+    string buffer;        // kept letters, written right-to-left: the normal form is buffer[begin, |w|)
+    int begin = 0;
+
+    // X-/Y-counters, clamped lazily (see LazyCounters in Shortlex.cpp)
+    vector<int> counterSeed;   // [charIndex] value before the first update
+    vector<int> counterSetAt;  // [charIndex] time of the last update, -1 if none
+    vector<int> capTime;       // monotone stack of the values written at each update time
+    vector<int> capValue;
+
+    SymbolMask alphabet;           // alph(w)
+    array<int, 256> buckets = {};  // counting sort of blocks, keyed by char order
+};
+
 // Testing Simon's congruence 논문 버전
 string computeShortlexNormalForm(const string &w, int k);
 
 // Simon's congruence pattern matching에서 필요한 버전
 ShortlexResult
 computePartialShortlexNormalForm(const string &w, vector<int> X_vector, vector<int> Y_vector, int threshold);
+
+// Kernel versions of the two functions above: O(|w| log |w| + alphabet size), with blocks reordered by counting sort,
+// and no heap allocation once `workspace` and `out` have grown large enough.
+void computeShortlexNormalForm(string_view w, int k, ShortlexWorkspace &workspace, string &out);
+
+// Fills every field of `out` except stackForm and alphabet, which are left empty (see stackMasks).
+// threads (0 = hardware concurrency): for inputs of 2^16 letters or more over at most 16 symbols with a threshold
+// below 254, the X-coordinate pass is split into chunks combined by a prefix scan of min-plus transfer summaries.
+// Step 2 then only visits letters up to the last one it may keep. The result is the same for every thread count.
+void computePartialShortlexNormalForm(string_view w,
+    const vector<int> &X_vector,
+    const vector<int> &Y_vector,
+    int threshold,
+    ShortlexWorkspace &workspace,
+    ShortlexResult &out,
+    int threads = 1);
+
+// u ~k v (Simon's congruence), i.e. computeShortlexNormalForm(u, k) == computeShortlexNormalForm(v, k).
+// Returns early on different alphabets or universality indices, and otherwise compares the two normal forms block
+// by block, stopping at the first block that differs.
+bool areSimonCongruent(const string &u, const string &v, int k);
+
+// Same as above on caller-owned workspaces (one per word), for many tests in a row
+bool areSimonCongruent(string_view u,
+    string_view v,
+    int k,
+    ShortlexWorkspace &uWorkspace,
+    ShortlexWorkspace &vWorkspace);
+
+// Strings longer than this are left to the scalar kernel by the batch version below
+constexpr int SHORTLEX_BATCH_MAX_LENGTH = 256;
+
+// Batch version of computePartialShortlexNormalForm for many short strings sharing the seeds and the threshold:
+// returns the normal form of every word. Words are processed 16 at a time with one 8-bit counter lane per word,
+// saturating at threshold + 1; longer words (and thresholds of 255 or more) go through the scalar kernel.
+vector<string> computePartialShortlexNormalForms(const vector<string> &words,
+    const vector<int> &X_vector,
+    const vector<int> &Y_vector,
+    int threshold);
+
+#endif  // SHORTLEX_H
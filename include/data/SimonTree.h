@@ -1,18 +1,25 @@
 #ifndef SIMON_TREE_H
 #define SIMON_TREE_H
 
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "data/Ranker.h"
+
 using namespace std;
 
 namespace SimonTree {
-struct Node {
+struct Node : enable_shared_from_this<Node> {
   int start;
   int end;
   int depth;
-  shared_ptr<Node> parent = nullptr;
+  Node *parent = nullptr; // non-owning: nodes are owned by `children` only, so a tree is freed with its root
   vector<shared_ptr<Node>> children;
 
   Node(int start, int end, int depth);
@@ -29,5 +36,132 @@ pair<shared_ptr<Node>, shared_ptr<Node>> splitNode(int i, shared_ptr<Node> root,
 void fixTree(shared_ptr<Node> root, int n);
 void printTree(const shared_ptr<Node> &node, const string &w,
                string indent = "", bool isLast = true);
+
+constexpr int32_t ROOT = 0;     // node id of the root
+constexpr int32_t NO_NODE = -1; // missing parent / child / sibling
+
+// Simon tree stored as parallel arrays indexed by int32 node ids, children as linked lists in left-to-right order.
+// Same tree as computeX / findNode / splitNode / fixTree build (1-based blocks [start, end]), in 24 bytes per node:
+// at most 2|w| + 1 nodes, reserved chunk by chunk, with no allocation per node.
+struct Tree {
+  vector<int32_t> start;       // [node]
+  vector<int32_t> end;         // [node]
+  vector<int32_t> depth;       // [node]
+  vector<int32_t> parent;      // [node] NO_NODE for the root
+  vector<int32_t> firstChild;  // [node] NO_NODE for a leaf
+  vector<int32_t> nextSibling; // [node] NO_NODE for a last child
+
+  int nodeCount() const { return start.size(); }
+  bool isLeaf(int32_t node) const { return firstChild[node] == NO_NODE; }
+};
+
+// Builds the Simon tree of w from the right (Algorithms 2 and 3), with the next occurrence of each letter read
+// from a 256-entry table instead of an X array: TreeBuilder below, fed w as one chunk
+Tree buildTree(const string &w);
+
+// Simon tree of a word fed in chunks from its end to its start, e.g. a log read backwards.
+// Only the open path lives in the builder (one entry per tree level, plus a 256-entry next-occurrence table);
+// every node is handed out once it is closed, which no later letter can change. By default closed nodes are
+// collected into the Tree returned by finish(); with a sink they are passed on instead and nothing is kept, so the
+// input may be far larger than memory.
+class TreeBuilder {
+public:
+  // A closed node, with the columns of Tree. The length of the word is not known while streaming, so start and
+  // end count from its end: the last letter is at 0, and adding |w| gives the 1-based positions of Tree.
+  struct ClosedNode {
+    int64_t node;
+    int64_t start;
+    int64_t end;
+    int64_t depth;
+    int64_t parent;
+    int64_t firstChild;
+    int64_t nextSibling;
+  };
+  using Sink = function<void(const ClosedNode &)>;
+
+  TreeBuilder();
+  explicit TreeBuilder(Sink sink);
+
+  // Feeds the chunk that comes right before everything fed so far
+  void pushFront(string_view chunk);
+
+  int64_t length() const { return letters; }
+  int64_t nodeCount() const { return nodes; }
+  int openDepth() const { return path.size() - 1; } // depth of the open leaf, i.e. Y of the first letter so far
+
+  // Closes the open path (fixTree), once all chunks are fed; call it once.
+  // Returns the tree of the whole word, or an empty Tree if a sink was given.
+  Tree finish();
+
+private:
+  struct OpenNode {
+    int64_t node;
+    int64_t end;
+    int64_t firstChild;
+    int64_t nextSibling;
+  };
+
+  Sink sink;
+  Tree tree; // closed nodes so far, without a sink
+  vector<OpenNode> path; // open path, the root first
+  array<int64_t, 256> nextSeen;
+  int64_t letters = 0;
+  int64_t nodes = 0;
+
+  int64_t openNode(int64_t end, int64_t nextSibling);
+  void close(const OpenNode &open, int64_t start, int depth);
+};
+
+// Same output as printTree above, from an iterative traversal: the stack depth does not grow with the tree
+void printTree(const Tree &tree, const string &w, ostream &out = cout);
+
+// Streams the tree as nested JSON objects {"start", "end", "depth", "children": [...]}, iteratively as well
+void writeTreeJson(const Tree &tree, ostream &out = cout);
+
+// Shortlex normal form of w under ~k, same result and signature as ::computeShortlexNormalForm.
+// The X- and Y-coordinates are read off as leaf depths of the Simon trees of w built from either end, keeping only
+// the open path of each tree: no per-symbol counters, O(n log k) overall, with blocks reordered by counting sort.
+// A standalone alternative for whole words: MatchSimK keeps the counter kernel, whose partial form is seeded with
+// X-/Y-vectors, which the trees do not model.
+string computeShortlexNormalForm(const string &w, int k);
+
+// Simon tree of w (buildTree) with what maxCongruenceLevel needs to match it against the tree of another word, so
+// that a word compared with many others is prepared once: O(|w| σ) time and space, for the next occurrences.
+// Positions are 1-based; position |w| + 1 stands for the empty suffix.
+struct CongruenceTree {
+  string word;
+  Tree tree;
+  vector<int32_t> childBegin;     // [node] the children of node are children[childBegin[node], childBegin[node + 1])
+  vector<int32_t> children;       // left to right
+  vector<int32_t> byAlphabetSize; // [c] child of the root whose suffixes have c distinct letters, NO_NODE if none
+  RankerTable next;               // X-ranks: getXByIndex(p - 1, c) is the first c at or after position p
+  vector<int32_t> adjacentLevel;  // [p] largest k with w[p:] ~k w[p + 1:], i.e. depth of the LCA of leaves p, p + 1
+  vector<vector<int32_t>> blockMin; // sparse table of minima of adjacentLevel over blocks of BLOCK positions
+
+  static constexpr int BLOCK = 32;
+
+  explicit CongruenceTree(const string &w);
+
+  int length() const { return word.size(); }
+
+  // Largest k with w[p:] ~k w[q:] (p, q in [1, |w| + 1]), INF if p == q. Classes of ~k among the suffixes are
+  // the blocks at depth k, so this is the minimum of adjacentLevel between p and q: O(BLOCK).
+  int level(int p, int q) const;
+};
+
+// Largest k with u ~k v (Simon distance), INF if u == v, from the Simon trees of u and v built under the same
+// Alphabet. The trees are matched from the root down: a block of T_u at depth k matches the block of T_v with the
+// same suffixes up to ~k, a child of the block matched by its parent, found by a merge over the children of both
+// (the matching preserves the order of blocks). A block whose parent has no match has none either, and a leaf keeps
+// matching below its depth until its match is a leaf too, whose level then follows from the next letters.
+// Each test is O(σ) and every block of either tree takes part in O(1) failed ones: O((|u| + |v|) σ) per pair,
+// linear for a fixed alphabet, after O((|u| + |v|) σ) to build the two CongruenceTrees.
+int maxCongruenceLevel(const CongruenceTree &u, const CongruenceTree &v);
+int maxCongruenceLevel(const string &u, const string &v);
+
+// maxCongruenceLevel of every pair of words: levels[i][j], INF on the diagonal. The CongruenceTree of each word is
+// built once and shared by all its pairs; trees and pairs are split over `threads` threads (0 = hardware
+// concurrency). An exception thrown for any word (a letter outside the Alphabet) is rethrown here.
+vector<vector<int>> maxCongruenceLevels(const vector<string> &words, int threads = 0);
 } // namespace SimonTree
 #endif // SIMON_TREE_H
\ No newline at end of file
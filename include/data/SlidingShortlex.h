@@ -0,0 +1,63 @@
+#ifndef SLIDING_SHORTLEX_H
+#define SLIDING_SHORTLEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "data/Shortlex.h"
+#include "utils/Fingerprint.h"
+
+using namespace std;
+
+/**
+ * k-SNF of a sliding window of letters, under pushBack and popFront.
+ *
+ * ~k is a congruence, so SNF(uv) = SNF(SNF(u) SNF(v)): the window is kept as a two-stack queue whose entries hold
+ * the normal form of their part of the window, and only normal forms (whose length does not depend on the window
+ * length) are ever concatenated. Each operation costs amortized O(1) normal forms of two such pieces.
+ * Letters must be in the alphabet set when the window was created.
+ */
+class SlidingShortlex {
+   public:
+    explicit SlidingShortlex(int k);
+
+    void pushBack(char c);
+
+    // Removes the oldest letter. Throws std::out_of_range if the window is empty.
+    void popFront();
+
+    int size() const { return front.size() + back.size(); }
+    bool empty() const { return size() == 0; }
+
+    // k-SNF of the current window
+    const string &normalForm();
+    Fingerprint fingerprint() { return Fingerprint::of(normalForm()); }
+
+    // Same normal form as computePartialShortlexNormalForm(window, ones, ones, k + 1), with its X-/Y-vectors,
+    // stack form and universality, computed from the normal form instead of the window
+    ShortlexResult shortlex();
+
+   private:
+    int k;
+
+    // Front stack: older letters, the oldest at the back. frontNormal[i] is the normal form of
+    // front[i] front[i-1] ... front[0], i.e. of the front part of the window starting at front[i].
+    vector<char> front;
+    vector<string> frontNormal;
+
+    // Back stack: letters pushed since the last transfer, oldest first, and their normal form
+    string back;
+    string backNormal;
+
+    string current;  // normal form of the window, valid if currentValid
+    bool currentValid = true;
+
+    ShortlexWorkspace workspace;
+    string scratch;
+
+    // normal form of u + v into out, which may alias u or v
+    void combine(string_view u, string_view v, string &out);
+};
+
+#endif  // SLIDING_SHORTLEX_H
@@ -0,0 +1,63 @@
+#ifndef TEXT_INDEX_H
+#define TEXT_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "data/Ranker.h"
+#include "utils/Common.h"
+
+struct TextIndexSegment;
+
+/**
+ * Persistent, read-only index of a text for a fixed alphabet.
+ *
+ * The file holds the encoded text, the segments left after slicing the text at chars outside the
+ * alphabet, and for every segment its X/Y ranker cells and arch tables (the X-/Y-tree parents).
+ * It is loaded with mmap, so several processes querying the same index share one copy of it.
+ *
+ * The segmentation and the arch tables depend on the alphabet, so an index only serves patterns
+ * whose alphabet is exactly the indexed one.
+ */
+class TextIndex {
+   public:
+    static constexpr uint32_t VERSION = 1;
+
+    // Builds the index of text over alphabet and writes it to path. Throws std::runtime_error on I/O errors.
+    static void build(const std::string &text, const std::string &alphabet, const std::string &path);
+
+    // Maps an index file. Throws std::runtime_error if it can't be read or isn't a valid index.
+    explicit TextIndex(const std::string &path);
+    ~TextIndex();
+
+    TextIndex(const TextIndex &) = delete;
+    TextIndex &operator=(const TextIndex &) = delete;
+
+    // Sorted, deduplicated alphabet the index was built for
+    const std::string &getAlphabet() const { return alphabet; }
+
+    int textLength() const;
+    int segmentCount() const;
+
+    // Space positions [start, end] of segment s in the text
+    Interval segment(int s) const;
+    std::string segmentText(int s) const;
+
+    // Ranker view over the mapped cells of segment s. Alphabet must be set to getAlphabet().
+    RankerTable rankers(int s) const;
+
+    // prnt(i) of the X-tree for i in [0, |segment|), and of the Y-tree for i in [1, |segment|]
+    const int32_t *xTreeParents(int s) const;
+    const int32_t *yTreeParents(int s) const;
+
+   private:
+    void *data = nullptr;
+    size_t size = 0;
+    std::string alphabet;
+
+    const TextIndexSegment &record(int s) const;
+    const void *at(uint64_t offset) const;
+};
+
+#endif  // TEXT_INDEX_H
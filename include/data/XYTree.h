@@ -1,45 +1,100 @@
 #ifndef XYTREE_H
 #define XYTREE_H
 
+#include <cstdint>
 #include <iostream>
-#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "data/Ranker.h"
 #include "data/Shortlex.h"
 #include "utils/Common.h"
+#include "utils/SymbolMask.h"
 
 using namespace std;
 
 namespace XYTree {
-    struct Node {
-        int index;
-        int r;
-        shared_ptr<Node> next;  // TODO: Y-tree에서는 필요 없는 값. 최적화 시 Y-tree에선 삭제 가능.
-        Interval children;      // [start, end]
+    constexpr int32_t ROOT = 0;      // node id of the root
+    constexpr int32_t NO_NODE = -1;  // nodeAt value of positions that are not nodes
 
-        Node(int index);
+    // X-/Y-tree stored as parallel arrays indexed by int32 node ids.
+    // Node 0 is the root (index INF in the X-tree, -1 in the Y-tree); the other nodes follow in discovery
+    // order, i.e. the order line 13 of MatchSimK visits them.
+    struct Tree {
+        vector<int32_t> index;      // [node] space position of the node
+        vector<int32_t> r;          // [node]
+        vector<Interval> children;  // [node] [start, end]
+        vector<int32_t> parent;     // [node] parent node, ROOT for the root itself
+
+        vector<int32_t> nodeAt;  // [position] node whose index is position, NO_NODE if none
+
+        // Y-tree only (empty in the X-tree): [position] node of prnt(position) for every position,
+        // since line 17 of MatchSimK starts from j_1, which need not be a node
+        vector<int32_t> positionParent;
+
+        // Binary lifting over node ids: jump[l][node] is the 2^l-th ancestor of node
+        vector<vector<int32_t>> jump;
+
+        int nodeCount() const { return index.size(); }
+
+        // Precomputes jump levels so that ancestor() answers up to maxSteps steps in O(log maxSteps)
+        void buildAncestors(int maxSteps);
+
+        // Node reached from `node` by `steps` >= 0 parent steps, stopping at the root.
+        // If path is given, the index of every node on the way is appended to it (root included), in O(steps).
+        int32_t ancestor(int32_t node, int steps, vector<int>* path = nullptr) const;
     };
 
-    inline std::ostream& operator<<(std::ostream& os, const Node& node) {
-        if (node.index == INF)
-            os << "(Node INF)";
-        else
-            os << "(Node " << node.index << ")";
-        return os;
+    // Prints node as "(Node <index>)" or "(Node INF)"
+    inline string describe(const Tree& tree, int32_t node) {
+        return tree.index[node] == INF ? "(Node INF)" : "(Node " + to_string(tree.index[node]) + ")";
     }
 
-    struct Tree {
-        shared_ptr<Node> root;
+    // How the builders compute prnt(i) when no precomputed parents are given
+    //   Ranker: max (X) / min (Y) over alph(p) of the ranker row of i, O(n * |alph(p)|)
+    //   Scan:   single pass keeping alph(p) ordered by last occurrence, O(n)
+    enum class ParentMode { Ranker, Scan };
 
-        vector<shared_ptr<Node>> parent;  // TODO: X-tree에서는 필요 없는 값. 최적화 시 X-tree에선 삭제 가능.
-    };
+    // prnt(i) of the X-tree for i in [0, |text|): X-rank of the end of the shortest arch over `symbols`
+    // starting at i, INF if there is none. Equals max_{a in symbols} R_X(text, i, a), in O(n).
+    vector<int32_t> computeXParents(const string& text, const SymbolMask& symbols);
+
+    // prnt(i) of the Y-tree for i in [1, |text|] (entry 0 is -1): start of the shortest arch over `symbols`
+    // ending right before i, -1 if there is none. Equals min_{a in symbols} R_Y(text, i, a), in O(n).
+    vector<int32_t> computeYParents(const string& text, const SymbolMask& symbols);
 
     // Build X-tree using the X-ranker, ShortlexResult, and input text
-    Tree buildXTree(const RankerTable& ranker, const ShortlexResult& shortlex, const string& text);
+    // parents: optional precomputed prnt(i) for i in [0, |text|) (e.g. from a TextIndex)
+    // threads: threads computing the r values of the nodes, which are independent of each other
+    Tree buildXTree(const RankerTable& ranker,
+        const ShortlexResult& shortlex,
+        const string& text,
+        const int32_t* parents = nullptr,
+        ParentMode mode = ParentMode::Scan,
+        int threads = 1);
 
     // Build Y-tree using the Y-ranker, ShortlexResult, and input text
-    Tree buildYTree(const RankerTable& ranker, const ShortlexResult& shortlex, const string& text);
+    // parents: optional precomputed prnt(i) for i in [1, |text|] (e.g. from a TextIndex)
+    // threads: threads computing the r values of the nodes, which are independent of each other
+    Tree buildYTree(const RankerTable& ranker,
+        const ShortlexResult& shortlex,
+        const string& text,
+        const int32_t* parents = nullptr,
+        ParentMode mode = ParentMode::Scan,
+        int threads = 1);
+
+    // Texts shorter than this are built serially by buildXYTrees: spawning threads costs more than it saves
+    constexpr int PARALLEL_MIN_LENGTH = 1 << 14;
+
+    // Builds the X-tree and the Y-tree concurrently, splitting `threads` (0 = hardware concurrency) between them.
+    // Gives the same trees as buildXTree and buildYTree.
+    pair<Tree, Tree> buildXYTrees(const RankerTable& ranker,
+        const ShortlexResult& shortlex,
+        const string& text,
+        int threads = 0,
+        const int32_t* xParents = nullptr,
+        const int32_t* yParents = nullptr);
 }  // namespace XYTree
 
 #endif  // XYTREE_H
@@ -1,8 +1,9 @@
 #ifndef ALPHABET_H
 #define ALPHABET_H
 
+#include <array>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
 
 class Alphabet {
    public:
@@ -15,29 +16,34 @@ class Alphabet {
 
     void setAlphabet(std::string value) {
         alphabet = value;
-        indexMap.clear();
-        for (int i = 0; i < alphabet.size(); i++) {
-            indexMap[alphabet[i]] = i;
-        }
+        buildIndexTable();
     }
 
     int size() { return alphabet.size(); }
 
     char indexToChar(int index) { return alphabet.at(index); }
 
-    int charToIndex(char c) { return indexMap.at(c); }
+    int charToIndex(char c) {
+        int index = indexTable[static_cast<unsigned char>(c)];
+        if (index < 0) throw std::out_of_range("Alphabet: char is not in the alphabet");
+        return index;
+    }
 
    private:
     // 기본 Alphabet (∑) 정의: 필요에 따라 수정
     std::string alphabet = "abcdefghijklmnopqrstuvwxyz";
 
-    std::unordered_map<char, int> indexMap;
+    // direct-indexed by unsigned char, -1 for chars outside the alphabet
+    std::array<int, 256> indexTable;
 
-    Alphabet() {
+    void buildIndexTable() {
+        indexTable.fill(-1);
         for (int i = 0; i < alphabet.size(); i++) {
-            indexMap[alphabet[i]] = i;
+            indexTable[static_cast<unsigned char>(alphabet[i])] = i;
         }
     }
+
+    Alphabet() { buildIndexTable(); }
     ~Alphabet() {}
 
     Alphabet(const Alphabet&) = delete;
@@ -1,47 +1,33 @@
 #ifndef CALCULATE_UNIVERSALITY_H
 #define CALCULATE_UNIVERSALITY_H
 
-#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
-#include "utils/Alphabet.h"
+// Arch factorization of text over the alphabet set in Alphabet: text = arch_1 ... arch_ι rest, where each arch is
+// the shortest prefix of what remains that contains every symbol. Returns the end position (inclusive) of every
+// arch, in order. Throws std::out_of_range on a char outside the alphabet.
+// threads (0 = hardware concurrency): texts of 2^16 chars or more are cut into chunks factorized in parallel, each
+// as if an arch started at its first char. A sequential pass then rescans each chunk from the true state at its
+// start, only until one of its arch ends meets a speculative one; from there on both factorizations agree.
+std::vector<int> archFactorization(std::string_view text, int threads = 1);
 
-inline int calculateUniversalityIndex(const std::string& text) {
-    const int alphabetSize = Alphabet::getInstance().size();
+// ι(text): the number of arches of the factorization above
+int calculateUniversalityIndex(const std::string& text, int threads = 1);
 
-    std::vector<int> required(alphabetSize, 0);     // target map: needed letters
-    std::vector<int> windowCount(alphabetSize, 0);  // current window count
+// k-universality of every suffix of text over the alphabet set in Alphabet, in O(|text|)
+struct UniversalityProfile {
+    std::vector<int> universality;  // [i] largest k such that text[i:] is k-universal, i in [0, |text|]
+    std::vector<int> archStarts;    // start positions of the arches of text counted from its end, increasing
+};
 
-    int archCount = 0;
-    int uniqueCount = 0;
-    int left = 0;
-    int n = text.size();
+// ι(text[i:]) for every i from one right-to-left scan: an arch is closed whenever every symbol has occurred since
+// the previous one, and ι(text[i:]) is the number of arch starts at or after i (ι is the same counted from either
+// end). Throws std::out_of_range on a char outside the alphabet.
+UniversalityProfile universalityProfile(std::string_view text);
 
-    for (int right = 0; right < n; ++right) {
-        char c = text[right];
-        int idx = Alphabet::getInstance().charToIndex(c);
+// universalityProfile of every text, over `threads` threads (0 = hardware concurrency)
+std::vector<UniversalityProfile> universalityProfiles(const std::vector<std::string>& texts, int threads = 0);
 
-        // expand window
-        if (windowCount[idx] == 0) {
-            ++uniqueCount;
-        }
-        ++windowCount[idx];
-
-        // check if current window is a minimal arch
-        if (uniqueCount == alphabetSize) {
-            ++archCount;
-
-            // move left to end of arch (minimize window)
-            left = right;
-
-            // reset counts
-            windowCount.assign(alphabetSize, 0);
-            uniqueCount = 0;
-        }
-    }
-
-    return archCount;
-}
 #endif  // CALCULATE_UNIVERSALITY_H
@@ -0,0 +1,34 @@
+#ifndef COUNTING_SORT_H
+#define COUNTING_SORT_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+// std::sort orders plain chars, which are signed on most targets: flipping the top bit maps that order to 0..255
+constexpr int CHAR_ORDER_FLIP = std::numeric_limits<char>::is_signed ? 0x80 : 0;
+
+inline int charKey(char c) { return static_cast<unsigned char>(c) ^ CHAR_ORDER_FLIP; }
+inline char keyChar(int key) { return static_cast<char>(key ^ CHAR_ORDER_FLIP); }
+
+// Sorts buffer[start, end) by char (in std::sort order) with one pass over the 256 buckets, which must be all 0
+// and are left all 0
+inline void countingSortBlock(std::string &buffer, int start, int end, std::array<int, 256> &buckets) {
+    uint64_t present[4] = {};
+    for (int i = start; i < end; i++) {
+        int key = charKey(buffer[i]);
+        buckets[key]++;
+        present[key >> 6] |= uint64_t(1) << (key & 63);
+    }
+
+    int i = start;
+    for (int word = 0; word < 4; word++) {
+        for (uint64_t bits = present[word]; bits != 0; bits &= bits - 1) {
+            int key = word * 64 + __builtin_ctzll(bits);
+            for (; buckets[key] > 0; buckets[key]--) buffer[i++] = keyChar(key);
+        }
+    }
+}
+
+#endif  // COUNTING_SORT_H
@@ -0,0 +1,56 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "utils/Alphabet.h"
+
+// Polynomial hash of a string over dense symbol ids (charToIndex + 1), modulo the Mersenne prime 2^61 - 1.
+// Composable: the fingerprint of uv is fingerprint(u) * BASE^|v| + fingerprint(v), so the fingerprint of a
+// concatenation is combined from the pieces without building it. Equal strings have equal fingerprints; two
+// different strings of length n collide with probability about n / 2^61.
+struct Fingerprint {
+    static constexpr uint64_t MODULUS = (uint64_t(1) << 61) - 1;
+    static constexpr uint64_t BASE = 0x1d8e4e27c47d124fULL % MODULUS;
+
+    uint64_t hash = 0;
+    uint64_t power = 1;  // BASE^length
+    int length = 0;
+
+    static Fingerprint of(std::string_view w) {
+        Fingerprint fingerprint;
+        for (char c : w) {
+            fingerprint.hash = add(multiply(fingerprint.hash, BASE), Alphabet::getInstance().charToIndex(c) + 1);
+            fingerprint.power = multiply(fingerprint.power, BASE);
+        }
+        fingerprint.length = w.size();
+        return fingerprint;
+    }
+
+    // this <- fingerprint of (this string) + (suffix string)
+    Fingerprint& operator+=(const Fingerprint& suffix) {
+        hash = add(multiply(hash, suffix.power), suffix.hash);
+        power = multiply(power, suffix.power);
+        length += suffix.length;
+        return *this;
+    }
+
+    bool operator==(const Fingerprint& other) const { return hash == other.hash && length == other.length; }
+    bool operator!=(const Fingerprint& other) const { return !(*this == other); }
+
+   private:
+    static uint64_t add(uint64_t a, uint64_t b) {
+        uint64_t sum = a + b;
+        return sum >= MODULUS ? sum - MODULUS : sum;
+    }
+
+    static uint64_t multiply(uint64_t a, uint64_t b) {
+        __uint128_t product = static_cast<__uint128_t>(a) * b;
+        uint64_t folded = static_cast<uint64_t>(product & MODULUS) + static_cast<uint64_t>(product >> 61);
+        folded = (folded & MODULUS) + (folded >> 61);
+        return folded >= MODULUS ? folded - MODULUS : folded;
+    }
+};
+
+#endif  // FINGERPRINT_H
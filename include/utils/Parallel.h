@@ -0,0 +1,69 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread count used when a caller asks for 0 threads
+inline int defaultThreadCount() {
+    int threads = std::thread::hardware_concurrency();
+    return threads > 0 ? threads : 1;
+}
+
+/**
+ * @brief Splits [begin, end) into at most `threads` contiguous chunks of near-equal size and runs
+ * f(chunkBegin, chunkEnd, chunkIndex) for each, one thread per chunk (the last one on the calling thread).
+ * threads <= 0 means defaultThreadCount(). Returns the number of chunks used.
+ * If any chunk throws, every thread is still joined and the first exception is rethrown on the calling thread.
+ */
+template <typename F>
+int parallelChunks(int begin, int end, int threads, F&& f) {
+    if (threads <= 0) threads = defaultThreadCount();
+    int length = std::max(0, end - begin);
+    int chunks = std::max(1, std::min(threads, length));
+
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto run = [&](int chunkBegin, int chunkEnd, int chunk) {
+        try {
+            f(chunkBegin, chunkEnd, chunk);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) failure = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(chunks - 1);
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        int chunkBegin = begin + static_cast<int>(static_cast<long long>(length) * chunk / chunks);
+        int chunkEnd = begin + static_cast<int>(static_cast<long long>(length) * (chunk + 1) / chunks);
+        if (chunk == chunks - 1) {
+            run(chunkBegin, chunkEnd, chunk);
+        } else {
+            try {
+                workers.emplace_back(run, chunkBegin, chunkEnd, chunk);
+            } catch (...) {
+                // no thread could be started: run the chunk here instead
+                run(chunkBegin, chunkEnd, chunk);
+            }
+        }
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    if (failure) std::rethrow_exception(failure);
+    return chunks;
+}
+
+// Runs f(i) for every i in [begin, end), split into contiguous chunks over `threads` threads
+template <typename F>
+void parallelFor(int begin, int end, int threads, F&& f) {
+    parallelChunks(begin, end, threads, [&f](int chunkBegin, int chunkEnd, int) {
+        for (int i = chunkBegin; i < chunkEnd; i++) f(i);
+    });
+}
+
+#endif  // PARALLEL_H
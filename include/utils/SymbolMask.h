@@ -0,0 +1,78 @@
+#ifndef SYMBOL_MASK_H
+#define SYMBOL_MASK_H
+
+#include <cstdint>
+
+#include "utils/Alphabet.h"
+
+/**
+ * Set of symbols as a bitmask over dense alphabet indexes (Alphabet::charToIndex).
+ * Four 64-bit words cover every possible char alphabet.
+ */
+struct SymbolMask {
+    static constexpr int WORDS = 4;
+
+    uint64_t words[WORDS] = {};
+
+    // Mask of the given chars under the current alphabet
+    template <typename Chars>
+    static SymbolMask fromChars(const Chars& chars) {
+        SymbolMask mask;
+        for (char c : chars) mask.set(Alphabet::getInstance().charToIndex(c));
+        return mask;
+    }
+
+    // Mask of the first `size` indexes
+    static SymbolMask firstN(int size) {
+        SymbolMask mask;
+        for (int w = 0; w < WORDS && size > 0; w++, size -= 64) {
+            mask.words[w] = size >= 64 ? ~uint64_t(0) : (uint64_t(1) << size) - 1;
+        }
+        return mask;
+    }
+
+    void set(int index) { words[index >> 6] |= uint64_t(1) << (index & 63); }
+    void reset(int index) { words[index >> 6] &= ~(uint64_t(1) << (index & 63)); }
+    bool test(int index) const { return (words[index >> 6] >> (index & 63)) & 1; }
+
+    bool empty() const { return (words[0] | words[1] | words[2] | words[3]) == 0; }
+
+    int count() const {
+        int total = 0;
+        for (uint64_t word : words) total += __builtin_popcountll(word);
+        return total;
+    }
+
+    // Lowest index in the mask, -1 if empty
+    int first() const {
+        for (int w = 0; w < WORDS; w++) {
+            if (words[w] != 0) return w * 64 + __builtin_ctzll(words[w]);
+        }
+        return -1;
+    }
+
+    // Calls f(index) for every index in ascending order
+    template <typename F>
+    void forEach(F&& f) const {
+        for (int w = 0; w < WORDS; w++) {
+            for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+                f(w * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+
+    bool operator==(const SymbolMask& other) const {
+        for (int w = 0; w < WORDS; w++) {
+            if (words[w] != other.words[w]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const SymbolMask& other) const { return !(*this == other); }
+
+    SymbolMask& operator|=(const SymbolMask& other) {
+        for (int w = 0; w < WORDS; w++) words[w] |= other.words[w];
+        return *this;
+    }
+};
+
+#endif  // SYMBOL_MASK_H
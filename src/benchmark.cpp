@@ -0,0 +1,715 @@
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "data/RangeShortlex.h"
+#include "data/Ranker.h"
+#include "data/Shortlex.h"
+#include "data/SimonTree.h"
+#include "data/SlidingShortlex.h"
+#include "data/XYTree.h"
+#include "utils/Alphabet.h"
+#include "utils/CalculateUniversality.h"
+#include "utils/Common.h"
+#include "utils/Parallel.h"
+#include "utils/RandomTextGenerator.h"
+
+using namespace std;
+
+// -------------------- Helpers --------------------
+template <typename F>
+double measureMillis(F&& f) {
+    auto begin = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - begin).count();
+}
+
+string makeAlphabet(int size) {
+    string alphabet;
+    for (int i = 0; i < size; i++) {
+        alphabet += static_cast<char>(size <= 26 ? 'a' + i : i);
+    }
+    return alphabet;
+}
+
+// Fixed words for the cross-checks next to the random ones, over the current alphabet: the empty word, unary runs
+// around 254 letters (where 8-bit lane counters saturate) and far beyond, a long run of every letter in turn, and
+// words whose universality index is exactly 3, one letter short of it, or 3 followed by long runs
+vector<string> edgeCaseWords() {
+    string alphabet = Alphabet::getInstance().getAlphabet();
+    char first = alphabet.front(), last = alphabet.back();
+    vector<string> words = {"", string(1, first)};
+    for (int length : {253, 254, 255, 256, 5000}) words.push_back(string(length, first));
+
+    string runs, arches;
+    for (char c : alphabet) runs += string(300, c);
+    for (int i = 0; i < 3; i++) arches += alphabet;
+    words.push_back(runs);
+    words.push_back(arches);
+    words.push_back(arches.substr(0, arches.size() - 1));
+    words.push_back(arches + string(300, last));
+    words.push_back(string(alphabet.rbegin(), alphabet.rend()) + arches + string(500, first) + alphabet);
+    return words;
+}
+
+// -------------------- Ranker --------------------
+// Nested-vector layout RankerTable used before the flat storage, kept here as the baseline.
+struct NestedRankerTable {
+    vector<vector<int>> xTable;
+    vector<vector<int>> yTable;
+
+    explicit NestedRankerTable(const string& text) {
+        int n = text.size();
+        int alphabetSize = Alphabet::getInstance().size();
+
+        xTable.assign(n + 1, vector<int>(alphabetSize, INF));
+        yTable.assign(n + 1, vector<int>(alphabetSize, -1));
+
+        vector<int> next(alphabetSize, INF);
+        for (int i = n - 1; i >= 0; --i) {
+            next[Alphabet::getInstance().charToIndex(text[i])] = i + 1;
+            for (int c = 0; c < alphabetSize; ++c) xTable[i][c] = next[c];
+        }
+
+        vector<int> prev(alphabetSize, -1);
+        for (int i = 0; i < n; ++i) {
+            prev[Alphabet::getInstance().charToIndex(text[i])] = i;
+            for (int c = 0; c < alphabetSize; ++c) yTable[i + 1][c] = prev[c];
+        }
+    }
+
+    size_t memoryUsage() const {
+        // each row is its own heap block: vector header + payload (+ malloc header, not counted)
+        size_t rows = xTable.size() + yTable.size();
+        return rows * sizeof(vector<int>) + rows * xTable[0].size() * sizeof(int);
+    }
+};
+
+void benchmarkRanker() {
+    cout << "RankerTable build: nested vector<vector<int>> vs flat width-adaptive storage" << endl;
+    cout << left << setw(8) << "sigma" << setw(12) << "n" << setw(14) << "nested(ms)" << setw(14) << "flat(ms)"
+         << setw(14) << "nested(MB)" << setw(14) << "flat(MB)"
+         << "cell" << endl;
+
+    for (int sigma : {4, 26}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+        for (int n : {10000, 60000, 1000000, 4000000}) {
+            string text = generateRandomText(n);
+
+            size_t nestedBytes = 0;
+            double nestedTime = measureMillis([&] {
+                NestedRankerTable nested(text);
+                nestedBytes = nested.memoryUsage();
+            });
+
+            size_t flatBytes = 0;
+            bool narrow = false;
+            double flatTime = measureMillis([&] {
+                RankerTable flat(text);
+                flat.buildXRankerTable();
+                flat.buildYRankerTable();
+                flatBytes = flat.memoryUsage();
+                narrow = flat.isNarrow();
+            });
+
+            cout << left << setw(8) << sigma << setw(12) << n << setw(14) << nestedTime << setw(14) << flatTime
+                 << setw(14) << nestedBytes / 1e6 << setw(14) << flatBytes / 1e6 << (narrow ? "uint16" : "uint32")
+                 << endl;
+        }
+    }
+}
+
+// -------------------- Parallel ranker build --------------------
+void benchmarkParallelRanker() {
+    cout << "RankerTable build: serial vs chunked parallel (X and Y built concurrently)" << endl;
+    cout << left << setw(8) << "sigma" << setw(12) << "n" << setw(10) << "threads" << setw(14) << "build(ms)"
+         << "identical" << endl;
+
+    for (int sigma : {4, 26}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+        for (int n : {1000000, 4000000}) {
+            string text = generateRandomText(n);
+
+            RankerTable serial(text, RankerTable::Backend::Table);
+            double serialTime = measureMillis([&] {
+                serial.buildXRankerTable();
+                serial.buildYRankerTable();
+            });
+            cout << left << setw(8) << sigma << setw(12) << n << setw(10) << 1 << setw(14) << serialTime << "-"
+                 << endl;
+
+            for (int threads : {2, 4, 8}) {
+                RankerTable parallel(text, RankerTable::Backend::Table);
+                double parallelTime = measureMillis([&] { parallel.buildRankerTables(threads); });
+
+                bool identical = true;
+                for (int i = 0; i <= n && identical; i++) {
+                    for (int c = 0; c < sigma && identical; c++) {
+                        identical = serial.getXByIndex(i, c) == parallel.getXByIndex(i, c) &&
+                                    serial.getYByIndex(i, c) == parallel.getYByIndex(i, c);
+                    }
+                }
+
+                cout << left << setw(8) << sigma << setw(12) << n << setw(10) << threads << setw(14) << parallelTime
+                     << (identical ? "yes" : "NO") << endl;
+            }
+        }
+    }
+}
+
+// -------------------- X-/Y-tree parents --------------------
+void benchmarkTreeParents() {
+    cout << "X-/Y-tree parents: max/min over ranker rows O(n*sigma) vs recency scan O(n)" << endl;
+    cout << left << setw(8) << "sigma" << setw(12) << "n" << setw(14) << "ranker(ms)" << setw(14) << "scan(ms)"
+         << "identical" << endl;
+
+    for (int sigma : {4, 26, 256}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+        SymbolMask symbols = SymbolMask::firstN(sigma);
+
+        for (int n : {60000, sigma == 256 ? 200000 : 1000000}) {
+            string text = generateRandomText(n);
+
+            RankerTable rankers(text);
+            rankers.buildXRankerTable();
+            rankers.buildYRankerTable();
+
+            vector<int32_t> rankerX(n), rankerY(n + 1, -1);
+            double rankerTime = measureMillis([&] {
+                rankers.maxX(0, n, symbols, rankerX.data());
+                rankers.minY(1, n + 1, symbols, rankerY.data() + 1);
+            });
+
+            vector<int32_t> scanX, scanY;
+            double scanTime = measureMillis([&] {
+                scanX = XYTree::computeXParents(text, symbols);
+                scanY = XYTree::computeYParents(text, symbols);
+            });
+
+            bool identical = rankerX == scanX && rankerY == scanY;
+            cout << left << setw(8) << sigma << setw(12) << n << setw(14) << rankerTime << setw(14) << scanTime
+                 << (identical ? "yes" : "NO") << endl;
+        }
+    }
+}
+
+// -------------------- Arch factorization --------------------
+// calculateUniversalityIndex as it was before archFactorization, kept here as the baseline: a count per symbol,
+// cleared with assign() after every arch
+int windowUniversality(const string& text) {
+    const int alphabetSize = Alphabet::getInstance().size();
+    vector<int> windowCount(alphabetSize, 0);
+    int archCount = 0;
+    int uniqueCount = 0;
+    for (char c : text) {
+        int idx = Alphabet::getInstance().charToIndex(c);
+        if (windowCount[idx] == 0) ++uniqueCount;
+        ++windowCount[idx];
+        if (uniqueCount == alphabetSize) {
+            ++archCount;
+            windowCount.assign(alphabetSize, 0);
+            uniqueCount = 0;
+        }
+    }
+    return archCount;
+}
+
+void benchmarkArchFactorization() {
+    cout << "Universality index of one long text: per-symbol counts vs archFactorization (hardware threads: "
+         << defaultThreadCount() << ")" << endl;
+    cout << left << setw(8) << "sigma" << setw(12) << "n" << setw(14) << "counts(ms)" << setw(10) << "threads"
+         << setw(14) << "arches(ms)" << "identical" << endl;
+
+    for (int sigma : {4, 26, 200}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+
+        for (int n : {1000000, 10000000}) {
+            string text = generateRandomText(n);
+
+            int counted = 0;
+            double countsTime = measureMillis([&] { counted = windowUniversality(text); });
+            vector<int> serial = archFactorization(text);
+
+            for (int threads : {1, 2, 4}) {
+                vector<int> ends;
+                double archesTime = measureMillis([&] { ends = archFactorization(text, threads); });
+
+                bool identical = static_cast<int>(ends.size()) == counted && ends == serial;
+                cout << left << setw(8) << sigma << setw(12) << n << setw(14) << countsTime << setw(10) << threads
+                     << setw(14) << archesTime << (identical ? "yes" : "NO") << endl;
+            }
+        }
+
+        // each fixed word, and all of them repeated past the parallel threshold, so that chunks start inside
+        // unary runs and next to arch ends; then a char outside the alphabet, which every thread count must throw
+        vector<string> texts = edgeCaseWords();
+        string repeated;
+        while (repeated.size() < 300000) {
+            for (const string& word : edgeCaseWords()) repeated += word;
+        }
+        texts.push_back(repeated);
+        bool identical = true;
+        for (const string& text : texts) {
+            vector<int> serial = archFactorization(text, 1);
+            for (int threads : {1, 2, 3, 4, 8}) {
+                vector<int> ends = archFactorization(text, threads);
+                identical = identical && static_cast<int>(ends.size()) == windowUniversality(text) && ends == serial;
+            }
+        }
+        for (size_t position : {size_t(0), repeated.size() / 2, repeated.size() - 1}) {
+            string invalid = repeated;
+            invalid[position] = static_cast<char>(250);
+            for (int threads : {1, 2, 4}) {
+                try {
+                    archFactorization(invalid, threads);
+                    identical = false;
+                } catch (const out_of_range&) {
+                }
+            }
+        }
+        cout << "fixed edge-case words, sigma " << sigma << ": " << (identical ? "yes" : "NO") << endl;
+    }
+}
+
+// -------------------- Shortlex coordinates --------------------
+// X-/Y-vectors of the partial normal form with the eager clamp used before the lazy counters, kept here as the
+// baseline: every update touches all sigma counters.
+pair<vector<int>, vector<int>> eagerShortlexVectors(const string& w, vector<int> X, vector<int> Y, int threshold) {
+    int n = w.size();
+    int sigma = X.size();
+    auto advance = [&](vector<int>& counters, int c) {
+        int value = counters[c]++;
+        for (int j = 0; j < sigma; j++) counters[j] = min(counters[j], counters[c]);
+        return value;
+    };
+
+    vector<int> xCoordinates(n);
+    vector<int> counters = X;
+    for (int i = 0; i < n; i++) xCoordinates[i] = advance(counters, Alphabet::getInstance().charToIndex(w[i]));
+
+    string kept;
+    counters = Y;
+    for (int i = n - 1; i >= 0; i--) {
+        int c = Alphabet::getInstance().charToIndex(w[i]);
+        if (xCoordinates[i] + counters[c] <= threshold) {
+            advance(counters, c);
+            kept += w[i];
+        }
+    }
+    vector<int> yVector = counters;
+
+    counters = X;
+    for (int i = kept.size() - 1; i >= 0; i--) advance(counters, Alphabet::getInstance().charToIndex(kept[i]));
+    return {counters, yVector};
+}
+
+void benchmarkShortlex() {
+    cout << "Partial shortlex normal form: eager O(n*sigma) clamp vs lazy counters (full kernel)" << endl;
+    cout << left << setw(8) << "sigma" << setw(12) << "n" << setw(10) << "text" << setw(12) << "threshold"
+         << setw(14) << "eager(ms)" << setw(14) << "lazy(ms)" << "identical" << endl;
+
+    for (int sigma : {4, 26, 256}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+
+        for (int n : {100000, 1000000}) {
+            vector<int> ones(sigma, 1);
+
+            // a long unary run keeps raising one counter: the lazy stack stays bounded by the threshold
+            for (string kind : {"random", "unary"}) {
+                string text =
+                    kind == "random" ? generateRandomText(n) : string(n, Alphabet::getInstance().indexToChar(0));
+
+                for (int threshold : {3, 1 << 20}) {
+                    pair<vector<int>, vector<int>> eager;
+                    double eagerTime =
+                        measureMillis([&] { eager = eagerShortlexVectors(text, ones, ones, threshold); });
+
+                    ShortlexWorkspace workspace;
+                    ShortlexResult lazy;
+                    double lazyTime = measureMillis(
+                        [&] { computePartialShortlexNormalForm(text, ones, ones, threshold, workspace, lazy); });
+
+                    bool identical = eager.first == lazy.X_vector && eager.second == lazy.Y_vector;
+                    cout << left << setw(8) << sigma << setw(12) << n << setw(10) << kind << setw(12) << threshold
+                         << setw(14) << eagerTime << setw(14) << lazyTime << (identical ? "yes" : "NO") << endl;
+                }
+            }
+        }
+
+        // thresholds where the lazy counters saturate right away, around the 8-bit lane limit, and never
+        vector<int> ones(sigma, 1);
+        bool identical = true;
+        for (const string& word : edgeCaseWords()) {
+            for (int threshold : {1, 2, 3, 253, 254, 255, 1 << 20}) {
+                pair<vector<int>, vector<int>> eager = eagerShortlexVectors(word, ones, ones, threshold);
+                ShortlexWorkspace workspace;
+                ShortlexResult lazy;
+                computePartialShortlexNormalForm(word, ones, ones, threshold, workspace, lazy);
+                identical = identical && eager.first == lazy.X_vector && eager.second == lazy.Y_vector;
+            }
+        }
+        cout << "fixed edge-case words, sigma " << sigma << ": " << (identical ? "yes" : "NO") << endl;
+    }
+}
+
+// Texts for the parallel X pass. Only "random" has every chunk universal; the others leave later chunks with
+// unsaturated counters, so a chunk summary that is off shows up in the X-coordinates of the next chunks.
+string makeParallelText(const string& kind, int n) {
+    string text = generateRandomText(n);
+    if (kind == "unary-tail") {
+        fill(text.begin() + n / 4, text.end(), Alphabet::getInstance().indexToChar(0));  // random quarter, a^(3n/4)
+    } else if (kind == "runs") {
+        int sigma = Alphabet::getInstance().size();
+        for (int i = 0; i < n; i++) {  // every other block of 50000 letters is a run of one letter
+            if ((i / 50000) % 2 == 1) text[i] = Alphabet::getInstance().indexToChar((i / 100000) % sigma);
+        }
+    }
+    return text;
+}
+
+void benchmarkShortlexParallel() {
+    cout << "Partial shortlex normal form of one long text: serial vs prefix-scan X pass (hardware threads: "
+         << defaultThreadCount() << ")" << endl;
+    cout << left << setw(8) << "sigma" << setw(12) << "n" << setw(12) << "text" << setw(12) << "threshold"
+         << setw(10) << "threads" << setw(12) << "time(ms)" << "identical" << endl;
+
+    for (int sigma : {4, 16}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+        vector<int> ones(sigma, 1);
+
+        for (int n : {1000000, 4000000}) {
+            for (string kind : {"random", "unary-tail", "runs"}) {
+                string text = makeParallelText(kind, n);
+
+                for (int threshold : {4, 10, 64}) {
+                    ShortlexWorkspace workspace;
+                    ShortlexResult serial;
+                    computePartialShortlexNormalForm(text, ones, ones, threshold, workspace, serial);
+
+                    for (int threads : {1, 2, 4, 8}) {
+                        ShortlexResult parallel;
+                        double time = measureMillis([&] {
+                            computePartialShortlexNormalForm(text, ones, ones, threshold, workspace, parallel, threads);
+                        });
+
+                        bool identical = serial.shortlexNormalForm == parallel.shortlexNormalForm &&
+                                         serial.X_vector == parallel.X_vector &&
+                                         serial.Y_vector == parallel.Y_vector && serial.arch_ends == parallel.arch_ends;
+                        cout << left << setw(8) << sigma << setw(12) << n << setw(12) << kind << setw(12) << threshold
+                             << setw(10) << threads << setw(12) << time << (identical ? "yes" : "NO") << endl;
+                        if (!identical) {
+                            cerr << "shortlex-parallel: " << threads << " threads differ from the serial pass on "
+                                 << kind << " text (sigma " << sigma << ", threshold " << threshold << ")" << endl;
+                            exit(1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void benchmarkShortlexBatch() {
+    cout << "Shortlex normal forms of many short strings: scalar kernel per string vs 16-lane batch" << endl;
+    cout << left << setw(8) << "sigma" << setw(10) << "length" << setw(10) << "strings" << setw(14) << "scalar(ms)"
+         << setw(14) << "batch(ms)" << "identical" << endl;
+
+    const int k = 3;
+    for (int sigma : {4, 26}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+        vector<int> ones(sigma, 1);
+
+        for (int length : {16, 64, 256}) {
+            int count = 4000000 / length;
+            vector<string> words(count);
+            for (string& word : words) word = generateRandomText(length);
+
+            vector<string> scalar(count);
+            double scalarTime = measureMillis([&] {
+                ShortlexWorkspace workspace;
+                ShortlexResult result;
+                for (int i = 0; i < count; i++) {
+                    computePartialShortlexNormalForm(words[i], ones, ones, k + 1, workspace, result);
+                    scalar[i] = result.shortlexNormalForm;
+                }
+            });
+
+            vector<string> batch;
+            double batchTime =
+                measureMillis([&] { batch = computePartialShortlexNormalForms(words, ones, ones, k + 1); });
+
+            cout << left << setw(8) << sigma << setw(10) << length << setw(10) << count << setw(14) << scalarTime
+                 << setw(14) << batchTime << (scalar == batch ? "yes" : "NO") << endl;
+        }
+
+        // the words, and their prefixes that fit a lane, batched together: lanes of different lengths, counters
+        // that saturate at the 8-bit limit, and thresholds on either side of the lane kernel's 254
+        vector<string> words = edgeCaseWords();
+        for (int i = words.size() - 1; i >= 0; i--) {
+            for (int length : {SHORTLEX_BATCH_MAX_LENGTH - 1, SHORTLEX_BATCH_MAX_LENGTH}) {
+                if (static_cast<int>(words[i].size()) > length) words.push_back(words[i].substr(0, length));
+            }
+        }
+        bool identical = true;
+        for (int threshold : {1, 2, 3, 253, 254, 255, 1 << 20}) {
+            vector<string> batch = computePartialShortlexNormalForms(words, ones, ones, threshold);
+            ShortlexWorkspace workspace;
+            ShortlexResult result;
+            for (size_t i = 0; i < words.size(); i++) {
+                computePartialShortlexNormalForm(words[i], ones, ones, threshold, workspace, result);
+                identical = identical && batch[i] == result.shortlexNormalForm;
+            }
+        }
+        cout << "fixed edge-case words, sigma " << sigma << ": " << (identical ? "yes" : "NO") << endl;
+    }
+}
+
+void benchmarkShortlexWindow() {
+    cout << "k-SNF of every window of a text: recompute per window vs SlidingShortlex (per window, in microseconds)"
+         << endl;
+    cout << left << setw(8) << "sigma" << setw(4) << "k" << setw(10) << "window" << setw(16) << "recompute(us)"
+         << setw(14) << "sliding(us)" << "identical" << endl;
+
+    const int windows = 2000;
+    for (int sigma : {4, 26}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+
+        for (int k : {2, 4}) {
+            for (int length : {1000, 100000}) {
+                string text = generateRandomText(length + windows);
+
+                vector<string> recomputed(windows);
+                double recomputeTime = measureMillis([&] {
+                    ShortlexWorkspace workspace;
+                    for (int i = 0; i < windows; i++) {
+                        computeShortlexNormalForm(string_view(text).substr(i, length), k, workspace, recomputed[i]);
+                    }
+                });
+
+                // filling the first window is not timed
+                vector<string> slid(windows);
+                SlidingShortlex window(k);
+                for (int i = 0; i < length; i++) window.pushBack(text[i]);
+                double slidingTime = measureMillis([&] {
+                    for (int i = 0; i < windows; i++) {
+                        if (i > 0) {
+                            window.popFront();
+                            window.pushBack(text[i + length - 1]);
+                        }
+                        slid[i] = window.normalForm();
+                    }
+                });
+
+                cout << left << setw(8) << sigma << setw(4) << k << setw(10) << length << setw(16)
+                     << recomputeTime * 1000 / windows << setw(14) << slidingTime * 1000 / windows
+                     << (recomputed == slid ? "yes" : "NO") << endl;
+            }
+        }
+
+        // every window of the fixed words laid end to end, empty windows included: windows inside and across unary
+        // runs, and k beyond the longest run
+        string text;
+        for (const string& word : edgeCaseWords()) text += word;
+        bool identical = true;
+        ShortlexWorkspace workspace;
+        string recomputed;
+        for (int k : {1, 3, 254, 6000}) {
+            for (int length : {0, 1, 255, 1000}) {
+                SlidingShortlex window(k);
+                for (int i = 0; i < length; i++) window.pushBack(text[i]);
+                for (int i = 0; i + length <= static_cast<int>(text.size()); i += 7) {
+                    computeShortlexNormalForm(string_view(text).substr(i, length), k, workspace, recomputed);
+                    identical = identical && window.normalForm() == recomputed;
+                    for (int j = i; j < i + 7 && j + length < static_cast<int>(text.size()); j++) {
+                        window.pushBack(text[j + length]);
+                        window.popFront();
+                    }
+                }
+            }
+        }
+        cout << "fixed edge-case words, sigma " << sigma << ": " << (identical ? "yes" : "NO") << endl;
+    }
+}
+
+void benchmarkShortlexRange() {
+    cout << "k-SNF of random factors of a text: recompute per factor vs RangeShortlex (per query, in microseconds)"
+         << endl;
+    cout << left << setw(8) << "sigma" << setw(4) << "k" << setw(12) << "n" << setw(12) << "build(ms)" << setw(16)
+         << "recompute(us)" << setw(12) << "range(us)" << "identical" << endl;
+
+    const int queries = 2000;
+    mt19937 generator(2024);
+    for (int sigma : {4, 26}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+
+        for (int k : {2, 4}) {
+            for (int n : {100000, 1000000}) {
+                string text = generateRandomText(n);
+                vector<pair<int, int>> ranges(queries);
+                for (auto& [begin, end] : ranges) {
+                    begin = uniform_int_distribution<int>(0, n)(generator);
+                    end = uniform_int_distribution<int>(begin, n)(generator);
+                }
+
+                vector<string> recomputed(queries);
+                double recomputeTime = measureMillis([&] {
+                    ShortlexWorkspace workspace;
+                    for (int i = 0; i < queries; i++) {
+                        auto [begin, end] = ranges[i];
+                        computeShortlexNormalForm(
+                            string_view(text).substr(begin, end - begin), k, workspace, recomputed[i]);
+                    }
+                });
+
+                unique_ptr<RangeShortlex> index;
+                double buildTime = measureMillis([&] { index = make_unique<RangeShortlex>(text, k); });
+                vector<string> answered(queries);
+                double rangeTime = measureMillis([&] {
+                    for (int i = 0; i < queries; i++) {
+                        answered[i] = index->normalForm(ranges[i].first, ranges[i].second);
+                    }
+                });
+
+                cout << left << setw(8) << sigma << setw(4) << k << setw(12) << n << setw(12) << buildTime << setw(16)
+                     << recomputeTime * 1000 / queries << setw(12) << rangeTime * 1000 / queries
+                     << (recomputed == answered ? "yes" : "NO") << endl;
+            }
+        }
+
+        // the fixed words laid end to end: every factor between two word or block boundaries (each word, runs
+        // split at a block edge, empty factors), plus the whole text and queries outside it, which must throw
+        string text;
+        vector<int> cuts = {0};
+        for (const string& word : edgeCaseWords()) {
+            text += word;
+            cuts.push_back(text.size());
+        }
+        for (int cut = 0; cut <= static_cast<int>(text.size()); cut += 5 * RangeShortlex::BLOCK + 1) {
+            cuts.push_back(cut);
+        }
+        bool identical = true;
+        ShortlexWorkspace workspace;
+        string recomputed;
+        for (int k : {1, 3, 254, 6000}) {
+            RangeShortlex index(text, k);
+            for (int begin : cuts) {
+                for (int end : cuts) {
+                    if (begin > end) continue;
+                    computeShortlexNormalForm(string_view(text).substr(begin, end - begin), k, workspace, recomputed);
+                    identical = identical && index.normalForm(begin, end) == recomputed;
+                }
+            }
+            for (pair<int, int> range : {pair<int, int>(-1, 0), {1, 0}, {0, index.size() + 1}}) {
+                try {
+                    index.normalForm(range.first, range.second);
+                    identical = false;
+                } catch (const out_of_range&) {
+                }
+            }
+        }
+        cout << "fixed edge-case words, sigma " << sigma << ": " << (identical ? "yes" : "NO") << endl;
+    }
+}
+
+void benchmarkSimonTreeShortlex() {
+    cout << "k-SNF: counter passes (Shortlex.cpp) vs Simon tree open paths (SimonTree.cpp)" << endl;
+    cout << left << setw(8) << "sigma" << setw(12) << "n" << setw(10) << "k" << setw(14) << "counters(ms)"
+         << setw(16) << "simon-tree(ms)" << "identical" << endl;
+
+    for (int sigma : {4, 26, 256}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+
+        for (int n : {100000, 1000000}) {
+            string text = generateRandomText(n);
+
+            for (int k : {3, 1 << 20}) {
+                string counters, simonTree;
+                double countersTime = measureMillis([&] { counters = computeShortlexNormalForm(text, k); });
+                double simonTreeTime =
+                    measureMillis([&] { simonTree = SimonTree::computeShortlexNormalForm(text, k); });
+
+                cout << left << setw(8) << sigma << setw(12) << n << setw(10) << k << setw(14) << countersTime
+                     << setw(16) << simonTreeTime << (counters == simonTree ? "yes" : "NO") << endl;
+            }
+        }
+    }
+}
+
+void benchmarkUniversalityProfile() {
+    cout << "k-universality of every suffix: calculateUniversalityIndex per suffix vs universalityProfile" << endl;
+    cout << left << setw(8) << "sigma" << setw(10) << "n" << setw(16) << "per-suffix(ms)" << setw(14) << "profile(ms)"
+         << "identical" << endl;
+
+    for (int sigma : {4, 26}) {
+        Alphabet::getInstance().setAlphabet(makeAlphabet(sigma));
+
+        for (int n : {1000, 10000, 30000}) {
+            string text = generateRandomText(n);
+
+            vector<int> perSuffix(n + 1);
+            double perSuffixTime = measureMillis([&] {
+                for (int i = 0; i <= n; i++) perSuffix[i] = calculateUniversalityIndex(text.substr(i));
+            });
+
+            UniversalityProfile profile;
+            double profileTime = measureMillis([&] { profile = universalityProfile(text); });
+
+            cout << left << setw(8) << sigma << setw(10) << n << setw(16) << perSuffixTime << setw(14) << profileTime
+                 << (perSuffix == profile.universality ? "yes" : "NO") << endl;
+        }
+    }
+
+    cout << "\nProfiles of many words: universalityProfiles (sigma 26, hardware threads: " << defaultThreadCount()
+         << ")" << endl;
+    cout << left << setw(10) << "words" << setw(10) << "length" << setw(10) << "threads" << "time(ms)" << endl;
+    vector<string> words(1000);
+    for (string& word : words) word = generateRandomText(100000);
+    for (int threads : {1, 2, 4}) {
+        double time = measureMillis([&] { universalityProfiles(words, threads); });
+        cout << left << setw(10) << words.size() << setw(10) << 100000 << setw(10) << threads << time << endl;
+    }
+}
+
+// ------------------
+// Benchmark driver: runs the selected suite, or every suite if none is given
+// ------------------
+int main(int argc, char* argv[]) {
+    map<string, function<void()>> suites = {
+        {"arch-factorization", benchmarkArchFactorization},
+        {"ranker", benchmarkRanker},
+        {"ranker-parallel", benchmarkParallelRanker},
+        {"tree-parents", benchmarkTreeParents},
+        {"shortlex", benchmarkShortlex},
+        {"shortlex-batch", benchmarkShortlexBatch},
+        {"shortlex-parallel", benchmarkShortlexParallel},
+        {"shortlex-range", benchmarkShortlexRange},
+        {"shortlex-window", benchmarkShortlexWindow},
+        {"universality-profile", benchmarkUniversalityProfile},
+        {"shortlex-simon-tree", benchmarkSimonTreeShortlex},
+    };
+
+    if (argc >= 2 && suites.count(argv[1]) == 0) {
+        cerr << "Unknown benchmark: " << argv[1] << endl;
+        cerr << "Usage: " << argv[0] << " [";
+        for (auto it = suites.begin(); it != suites.end(); ++it) {
+            cerr << (it == suites.begin() ? "" : " | ") << it->first;
+        }
+        cerr << "]" << endl;
+        return 1;
+    }
+
+    for (auto& [name, suite] : suites) {
+        if (argc >= 2 && name != argv[1]) continue;
+        suite();
+        cout << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "data/TextIndex.h"
+
+using namespace std;
+
+// ------------------
+// Builds a TextIndex file from a test input file (first line: alphabet, second line: text)
+// ------------------
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "You must enter a test input file and an output index file" << endl;
+        cerr << "Usage: " << argv[0] << " <test-input-file-name> <index-file-name>" << endl;
+        return 1;
+    }
+
+    string inputFileName = argv[1];
+    ifstream inputFile(inputFileName);
+    if (!inputFile) {
+        cerr << "Error opening " << inputFileName << endl;
+        return 1;
+    }
+
+    string alphabet;
+    string text;
+    getline(inputFile, alphabet);
+    getline(inputFile, text);
+
+    try {
+        TextIndex::build(text, alphabet, argv[2]);
+        TextIndex index(argv[2]);
+        cout << "indexed " << index.textLength() << " chars in " << index.segmentCount() << " segments over alphabet \""
+             << index.getAlphabet() << "\" into " << argv[2] << endl;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
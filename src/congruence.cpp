@@ -0,0 +1,80 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "data/Shortlex.h"
+#include "utils/Alphabet.h"
+#include "utils/Parallel.h"
+
+using namespace std;
+
+// ------------------
+// Batch driver for areSimonCongruent.
+// Input file: first line is the alphabet, every following non-empty line is a triple "u v k".
+// Prints "yes" or "no" for every triple, in input order.
+// ------------------
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "You must enter a test input file" << endl;
+        cerr << "Usage: " << argv[0] << " <test-input-file-name> [threads]" << endl;
+        return 1;
+    }
+
+    string inputFileName = argv[1];
+    ifstream inputFile(inputFileName);
+    if (!inputFile) {
+        cerr << "Error opening " << inputFileName << endl;
+        return 1;
+    }
+    int threads = argc >= 3 ? stoi(argv[2]) : 0;  // 0 = hardware concurrency
+
+    // read inputs
+    string alphabet;
+    getline(inputFile, alphabet);
+    Alphabet::getInstance().setAlphabet(alphabet);
+
+    vector<string> us, vs;
+    vector<int> ks;
+    string line;
+    for (int lineNumber = 2; getline(inputFile, line); lineNumber++) {
+        if (line.empty()) continue;
+        istringstream triple(line);
+        string u, v;
+        int k;
+        if (!(triple >> u >> v >> k)) {
+            cerr << "Line " << lineNumber << ": expected \"u v k\"" << endl;
+            return 1;
+        }
+        us.push_back(u);
+        vs.push_back(v);
+        ks.push_back(k);
+    }
+
+    // check the triples, one pair of workspaces per thread
+    int count = ks.size();
+    vector<int> congruent(count);  // 1 / 0, -1 on a char outside the alphabet
+    parallelChunks(0, count, threads, [&](int chunkBegin, int chunkEnd, int) {
+        ShortlexWorkspace uWorkspace, vWorkspace;
+        for (int i = chunkBegin; i < chunkEnd; i++) {
+            try {
+                congruent[i] = areSimonCongruent(us[i], vs[i], ks[i], uWorkspace, vWorkspace);
+            } catch (const out_of_range&) {
+                congruent[i] = -1;
+            }
+        }
+    });
+
+    for (int i = 0; i < count; i++) {
+        if (congruent[i] < 0) {
+            cerr << "Triple " << i + 1 << ": word has a char outside the alphabet" << endl;
+            return 1;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        cout << (congruent[i] ? "yes" : "no") << endl;
+    }
+
+    return 0;
+}
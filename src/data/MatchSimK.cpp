@@ -1,11 +1,14 @@
 #include "data/MatchSimK.h"
 
 #include <iostream>
+#include <unordered_map>
 
+#include "data/TextIndex.h"
 #include "data/XYTree.h"
 #include "utils/Alphabet.h"
 #include "utils/CalculateUniversality.h"
 #include "utils/Common.h"
+#include "utils/SymbolMask.h"
 
 auto printVector = [](const vector<int>& v, const string& name) {
     cout << name << " = [ ";
@@ -15,177 +18,134 @@ auto printVector = [](const vector<int>& v, const string& name) {
     cout << "]" << endl;
 };
 
-/**
- * MatchSimK 알고리즘 구현
- */
-vector<MatchSimK::triple> MatchSimK::matchSimK(const string& text, const string& pattern, int k) {
-    // line 1: Given: a pattern p, a text T, an integer k
-
-    // 일부 데이터 전처리
-    set<char> alph_p;
-    for (char c : pattern) {
-        alph_p.insert(c);
-    }
-    string alph_p_string(alph_p.begin(), alph_p.end());
-    Alphabet::getInstance().setAlphabet(alph_p_string);
-    int pattern_universality = calculateUniversalityIndex(pattern);
-
-    debug(cout << "Computing MatchSimK..." << endl);
-
-    // line 2: Returns: a set S of tripes where, for space positions f and b of T,
-    // T[f : b] ~k p if and only if there exists some element e = ([f_1, f_2], [b_1, b_2], offset) in S
-    // such that space positions f - offset \in [f_1, f_2] and b - offset \in [b_1, b_2]
-
-    // line 3: positions <- empty set
-    vector<triple> positions;
-
-    // line 4: s_p <-ShortLex_k(p) in stack form
-    ShortlexResult shortlex_p = computePartialShortlexNormalForm(pattern,
-        vector<int>(Alphabet::getInstance().size(), 1),
-        vector<int>(Alphabet::getInstance().size(), 1),
-        k + 1);  // stack form = shortlex_p.stackForm
-    debug(cout << "shortlex normal form of pattern is: " << shortlex_p.shortlexNormalForm << endl);
-
-    // preprocessing: if P is a universal pattern
-    int k_pattern = calculateUniversalityIndex(pattern);
-    bool isUniversalPattern = (k <= k_pattern);
-
-    // line 5: Slice T whenever T[i] \not-in alph(p)
-    vector<Interval> sub_Ts;
-    int start = 0;
-    int end = 0;
-    for (char t : text) {
-        if (alph_p.count(t) == 0) {
-            if (start < end) sub_Ts.emplace_back(start, end);
-            end++;
-            start = end;
-            continue;
+namespace {
+    // Everything MatchSimK derives from the pattern alone
+    struct PatternInfo {
+        set<char> alph_p;
+        ShortlexResult shortlex_p;
+        int pattern_universality;
+        bool isUniversalPattern;
+        SymbolMask A;  // dense alphabet indexes
+        SymbolMask B;
+    };
+
+    /**
+     * Pattern preprocessing of MatchSimK (lines 4, 6 and 7). Also sets the alphabet to alph(p).
+     */
+    PatternInfo preprocessPattern(const string& pattern, int k) {
+        PatternInfo info;
+
+        // 일부 데이터 전처리
+        for (char c : pattern) {
+            info.alph_p.insert(c);
         }
-        end++;
-    }
-    if (start < end) {
-        sub_Ts.emplace_back(start, end);
-    }
+        string alph_p_string(info.alph_p.begin(), info.alph_p.end());
+        Alphabet::getInstance().setAlphabet(alph_p_string);
+        info.pattern_universality = calculateUniversalityIndex(pattern);
+
+        // line 4: s_p <-ShortLex_k(p) in stack form
+        info.shortlex_p = computePartialShortlexNormalForm(pattern,
+            vector<int>(Alphabet::getInstance().size(), 1),
+            vector<int>(Alphabet::getInstance().size(), 1),
+            k + 1);  // stack form = shortlex_p.stackForm
+        debug(cout << "shortlex normal form of pattern is: " << info.shortlex_p.shortlexNormalForm << endl);
+
+        // preprocessing: if P is a universal pattern
+        info.isUniversalPattern = (k <= info.pattern_universality);
+
+        // line 6: A <- {σ | pσ not~k p}
+        // line 7: B <- {σ | σp not~k p}
+        for (char sigma : info.alph_p) {
+            int index = Alphabet::getInstance().charToIndex(sigma);
+            int X = info.shortlex_p.X_vector[index];
+            int Y = info.shortlex_p.Y_vector[index];
+
+            if (X + 1 <= k + 1) {
+                info.A.set(index);
+            };
+
+            if (1 + Y <= k + 1) {
+                info.B.set(index);
+            };
+        }
+        debug(
+            cout << "A: "; info.A.forEach([](int a) { cout << Alphabet::getInstance().indexToChar(a) << " "; });
+            cout << endl; cout << "B: ";
+            info.B.forEach([](int b) { cout << Alphabet::getInstance().indexToChar(b) << " "; }); cout << endl;);
 
-    // line 6: A <- {σ | pσ not~k p}
-    // line 7: B <- {σ | σp not~k p}
-    set<char> A;
-    set<char> B;
-    for (char sigma : alph_p) {
-        int index = Alphabet::getInstance().charToIndex(sigma);
-        int X = shortlex_p.X_vector[index];
-        int Y = shortlex_p.Y_vector[index];
-
-        if (X + 1 <= k + 1) {
-            A.insert(sigma);
-        };
-
-        if (1 + Y <= k + 1) {
-            B.insert(sigma);
-        };
+        return info;
     }
-    debug(
-        cout << "A: "; for (char sigma : A) { cout << sigma << " "; } cout << endl; cout << "B: ";
-        for (char sigma : B) { cout << sigma << " "; } cout << endl;);
 
-    // line 8: for all sliced substrings T' of T do
-    for (Interval sub_T : sub_Ts) {
-        string sub_T_string = text.substr(sub_T.start, sub_T.end - sub_T.start);
-        debug(cout << "For sub_T string: " << sub_T_string << endl);
-
-        // line 9: offset <- the start space position of T' in T
-        int offset = sub_T.start;
+    /**
+     * Lines 10, 13-26 of MatchSimK for one sliced substring T' of T, whose rankers and trees are already built.
+     */
+    void matchSubText(const PatternInfo& info,
+        int k,
+        const string& sub_T_string,
+        int offset,
+        const RankerTable& rankers,
+        XYTree::Tree& x_tree,
+        XYTree::Tree& y_tree,
+        vector<MatchSimK::triple>& positions) {
+        using MatchSimK::CheckPoint;
+
+        const ShortlexResult& shortlex_p = info.shortlex_p;
+        const SymbolMask& A = info.A;
+        const SymbolMask& B = info.B;
+        const int pattern_universality = info.pattern_universality;
+        const bool isUniversalPattern = info.isUniversalPattern;
 
         // line 10: Map <- empty map for saving vectors and substrings
-        unordered_map<int, string> map;  // TODO: checkpoint 관련 구현 시 수정
-
-        // line 11: Preprocess X- and Y-ranker array
-        RankerTable rankers = RankerTable(sub_T_string);
-        rankers.buildXRankerTable();
-        rankers.buildYRankerTable();
-
-        // line 12: Construct X-tree T_X(T') and Y-tree T_Y(T')
-        XYTree::Tree x_tree = XYTree::buildXTree(rankers, shortlex_p, sub_T_string);
-        XYTree::Tree y_tree = XYTree::buildYTree(rankers, shortlex_p, sub_T_string);
-
         // make a sub_tree length of vector
         // which stores check_point starting from such indexes
-        vector<vector<CheckPoint>> check_points(sub_T.end - sub_T.start + 1);
-        debug(cout << "checkpoint was initialized with max size " << sub_T.end - sub_T.start + 1 << "\n");
+        vector<vector<CheckPoint>> check_points(sub_T_string.size() + 1);
+        debug(cout << "checkpoint was initialized with max size " << sub_T_string.size() + 1 << "\n");
+        ShortlexWorkspace workspace;
+
+        // lines 14 and 17 walk ι(p)-1 and ι(p) edges up the trees: answer them by binary lifting
+        x_tree.buildAncestors(pattern_universality - 1);
+        y_tree.buildAncestors(pattern_universality - 1);
 
         // line 13: for all nodes i \in T_X(T').nodes do
-        for (shared_ptr<XYTree::Node> node_i = x_tree.root->next; node_i != x_tree.root; node_i = node_i->next) {
+        for (int32_t node_i = 1; node_i < x_tree.nodeCount(); node_i++) {
             int j_1;
             int j_2;
             if(!isUniversalPattern) {
-                // preprocessing: make vector x_arch_indexes to save the end points of x-arch links
-                vector<int> x_arch_indexes;
-                x_arch_indexes.push_back(node_i->index);
-                debug(cout << "add to x_arch_indexes: " << node_i->index << endl);
                 // line 14: From i, go up the X-tree for ι(p)-1 edges
-                shared_ptr<XYTree::Node> current_node = node_i;
-                debug(cout << "starting X-tree traversal from: " << *current_node << endl);
-                for (int i = 0; i < pattern_universality - 1; i++) {
-                    current_node = x_tree.parent[current_node->index];
-                    x_arch_indexes.push_back(current_node->index);
-                    debug(cout << "add to x_arch_indexes: " << current_node->index << endl);
-                    debug(cout << "traversing X-tree: " << *current_node << endl);
-                    if (current_node == x_tree.root) break;
-                }
-                if (current_node == x_tree.root) {
+                int32_t x_node = x_tree.ancestor(node_i, pattern_universality - 1);
+                if (x_node == XYTree::ROOT) {
                     debug(cout << "reached root while traversing X-tree. Skipping to next T'" << endl);
                     continue;
                 }
-                debug(cout << "X-tree ends at: " << *current_node << endl);
+                debug(cout << "X-tree ends at: " << XYTree::describe(x_tree, x_node) << endl);
 
                 // line 15: j_1 <- T_X(T').r(current node)
-                j_1 = current_node->r;
+                j_1 = x_tree.r[x_node];
                 debug(cout << "j_1 value: " << j_1 << endl);
 
                 // line 16: if j_1 = ∞, break.
                 if (j_1 == INF) break;
 
-                // preprocessing: make vector y_arch_indexes to save the end points of y-arch links
-                vector<int> y_arch_indexes;
-                y_arch_indexes.push_back(j_1);
-
                 // line 17: From j_1, go up the Y-tree using ι(p) calls of T_Y(T').prnt()
-                debug(cout << "starting Y-tree traversal from: " << *current_node << endl);
-                current_node = y_tree.parent[j_1];
-                y_arch_indexes.push_back(current_node->index);
-                debug(cout << "add to y_arch_indexes: " << current_node->index << endl);
-                debug(cout << "Y-tree start becomes: " << *current_node << endl);
-                for (int i = 0; i < pattern_universality - 1; i++) {
-                    current_node = y_tree.parent[current_node->index];
-                    y_arch_indexes.push_back(current_node->index);
-                    debug(cout << "add to y_arch_indexes: " << current_node->index << endl);
-                    debug(cout << "traversing Y-tree: " << *current_node << endl);
-                    if (current_node == y_tree.root) break;
-                }
-                if (current_node == y_tree.root) {
+                int32_t y_node = y_tree.ancestor(y_tree.positionParent[j_1], pattern_universality - 1);
+                if (y_node == XYTree::ROOT) {
                     debug(cout << "reached root while traversing Y-tree. Skipping to next T'" << endl);
                     continue;
                 }
-                debug(cout << "Y-tree ends at: " << *current_node << endl);
+                debug(cout << "Y-tree ends at: " << XYTree::describe(y_tree, y_node) << endl);
 
                 // line 18: n <- current node
-                int n = current_node->r;
+                int n = y_tree.r[y_node];
 
                 // line 19: j_2 <- max(T_X(T').chld(i) AND [max_{σ in B}{R_Y(T', n, σ)+1, n}])
-                debug(cout << "children of " << *node_i << " are: " << node_i->children << endl);
-                int max_r_y = -1;
-                for (char sigma : B) {
-                    int r_y = rankers.getY(n, sigma) + 1;
-                    debug(cout << "ranker_Y = " << r_y-1 << " (n=" << n << ", sigma=" << sigma << ")" << endl);
-                    if (r_y != -1) {
-                        max_r_y = max(r_y, max_r_y);
-                    }
-                }
+                debug(cout << "children of " << XYTree::describe(x_tree, node_i) << " are: " << x_tree.children[node_i] << endl);
+                int max_r_y = B.empty() ? -1 : rankers.maxY(n, B) + 1;
+                debug(cout << "max ranker_Y + 1 over B = " << max_r_y << " (n=" << n << ")" << endl);
                 Interval j_2_candidate = Interval(max_r_y, n);
 
-                int intersection_start = max(node_i->children.start, j_2_candidate.start);
-                int intersection_end = min(node_i->children.end, j_2_candidate.end);
-                debug(cout << "Intv 1 (chld): " << node_i->children << endl);
+                int intersection_start = max(x_tree.children[node_i].start, j_2_candidate.start);
+                int intersection_end = min(x_tree.children[node_i].end, j_2_candidate.end);
+                debug(cout << "Intv 1 (chld): " << x_tree.children[node_i] << endl);
                 debug(cout << "Intv 2 (j_2): " << j_2_candidate << endl);
                 if (intersection_start <= intersection_end) {
                     j_2 = intersection_end;
@@ -196,76 +156,61 @@ vector<MatchSimK::triple> MatchSimK::matchSimK(const string& text, const string&
                 }
                 debug(cout << "j_2 value: " << j_2 << endl);
 
-                // make j_2 a starting point of x_arch_indexes
-                x_arch_indexes.insert(x_arch_indexes.begin(), j_2);
+                // end points of the x-arch links, starting from j_2, and of the y-arch links, starting from j_1.
+                // Only collected here, once z is actually needed.
+                vector<int> x_arch_indexes = {j_2, x_tree.index[node_i]};
+                x_tree.ancestor(node_i, pattern_universality - 1, &x_arch_indexes);
+                vector<int> y_arch_indexes = {j_1, y_tree.index[y_tree.positionParent[j_1]]};
+                y_tree.ancestor(y_tree.positionParent[j_1], pattern_universality - 1, &y_arch_indexes);
+                debug(printVector(x_arch_indexes, "x_arch_indexes"));
+                debug(printVector(y_arch_indexes, "y_arch_indexes"));
 
                 // line 21: z <- ShortLex_k(T'[j_2 : j_1]) using the checkpoint mechanism and Map
                 // line 22: Save Checkpoints for each arch link of T'[j_2 : j_1]
-                string z = shortlex_with_checkpoint(k, pattern_universality, sub_T_string, check_points, x_arch_indexes, y_arch_indexes);
+                vector<const CheckPoint*> z_pieces = MatchSimK::link_checkpoints(
+                    k, pattern_universality, sub_T_string, check_points, x_arch_indexes, y_arch_indexes, workspace);
 
                 // line 23: if z ~k ShortLex(p)
-                if(z != shortlex_p.shortlexNormalForm) continue;
+                if (!MatchSimK::matches_shortlex(z_pieces, shortlex_p)) continue;
             } else {
                 // edge case universal pattern: same as non-universal case, except no need to save arches
                 // line 14: From i, go up the X-tree for ι(p)-1 edges
-                shared_ptr<XYTree::Node> current_node = node_i;
-                debug(cout << "starting X-tree traversal from: " << *current_node << endl);
-                for (int i = 0; i < pattern_universality - 1; i++) {
-                    current_node = x_tree.parent[current_node->index];
-                    debug(cout << "add to x_arch_indexes: " << current_node->index << endl);
-                    debug(cout << "traversing X-tree: " << *current_node << endl);
-                    if (current_node == x_tree.root) break;
-                }
-                if (current_node == x_tree.root) {
+                int32_t x_node = x_tree.ancestor(node_i, pattern_universality - 1);
+                if (x_node == XYTree::ROOT) {
                     debug(cout << "reached root while traversing X-tree. Skipping to next T'" << endl);
                     continue;
                 }
-                debug(cout << "X-tree ends at: " << *current_node << endl);
+                debug(cout << "X-tree ends at: " << XYTree::describe(x_tree, x_node) << endl);
 
                 // line 15: j_1 <- T_X(T').r(current node)
                 // in universal case, no r exists
-                j_1 = current_node->index;
+                j_1 = x_tree.index[x_node];
                 debug(cout << "j_1 value: " << j_1 << endl);
 
                 // line 16: if j_1 = ∞, break.
                 if (j_1 == INF) break;
 
                 // line 17: From j_1, go up the Y-tree using ι(p) calls of T_Y(T').prnt()
-                debug(cout << "starting Y-tree traversal from: " << *current_node << endl);
-                current_node = y_tree.parent[j_1];
-                debug(cout << "add to y_arch_indexes: " << current_node->index << endl);
-                debug(cout << "Y-tree start becomes: " << *current_node << endl);
-                for (int i = 0; i < pattern_universality - 1; i++) {
-                    current_node = y_tree.parent[current_node->index];
-                    debug(cout << "add to y_arch_indexes: " << current_node->index << endl);
-                    debug(cout << "traversing Y-tree: " << *current_node << endl);
-                    if (current_node == y_tree.root) break;
-                }
-                if (current_node == y_tree.root) {
+                int32_t y_node = y_tree.ancestor(y_tree.positionParent[j_1], pattern_universality - 1);
+                if (y_node == XYTree::ROOT) {
                     debug(cout << "reached root while traversing Y-tree. Skipping to next T'" << endl);
                     continue;
                 }
-                debug(cout << "Y-tree ends at: " << *current_node << endl);
+                debug(cout << "Y-tree ends at: " << XYTree::describe(y_tree, y_node) << endl);
 
                 // line 18: n <- current node
                 // in universal case, no r exists
-                int n = current_node->index;
+                int n = y_tree.index[y_node];
 
                 // line 19: j_2 <- max(T_X(T').chld(i) AND [max_{σ in B}{R_Y(T', n, σ)+1, n}])
-                debug(cout << "children of " << *node_i << " are: " << node_i->children << endl);
-                int max_r_y = -1;
-                for (char sigma : B) {
-                    int r_y = rankers.getY(n, sigma) + 1;
-                    debug(cout << "ranker_Y = " << r_y-1 << " (n=" << n << ", sigma=" << sigma << ")" << endl);
-                    if (r_y != -1) {
-                        max_r_y = max(r_y, max_r_y);
-                    }
-                }
+                debug(cout << "children of " << XYTree::describe(x_tree, node_i) << " are: " << x_tree.children[node_i] << endl);
+                int max_r_y = B.empty() ? -1 : rankers.maxY(n, B) + 1;
+                debug(cout << "max ranker_Y + 1 over B = " << max_r_y << " (n=" << n << ")" << endl);
                 Interval j_2_candidate = Interval(max_r_y, n);
 
-                int intersection_start = max(node_i->children.start, j_2_candidate.start);
-                int intersection_end = min(node_i->children.end, j_2_candidate.end);
-                debug(cout << "Intv 1 (chld): " << node_i->children << endl);
+                int intersection_start = max(x_tree.children[node_i].start, j_2_candidate.start);
+                int intersection_end = min(x_tree.children[node_i].end, j_2_candidate.end);
+                debug(cout << "Intv 1 (chld): " << x_tree.children[node_i] << endl);
                 debug(cout << "Intv 2 (j_2): " << j_2_candidate << endl);
                 if (intersection_start <= intersection_end) {
                     j_2 = intersection_end;
@@ -278,25 +223,18 @@ vector<MatchSimK::triple> MatchSimK::matchSimK(const string& text, const string&
 
                 // line 23: condition is already true
             }
-            
+        
             debug(cout << "\n[DEBUG] z == shortlex_p.shortlexNormalForm MATCHED\n");
-            
+        
             // line 24: interval1 <- T_X(T').chld(i) AND [max_{σ in B}{R_Y(T', j_2, σ)+1, j_2}]
             debug(cout << "[interval1] Computing from B and getY(j_2 = " << j_2 << ")\n");
 
-            int interval1_start = -1;
-            for (char sigma : B) {
-                int r_y = rankers.getY(j_2, sigma);
-                debug(cout << "  - B contains '" << sigma << "', getY(" << j_2 << ", '" << sigma << "') = "
-                            << ((r_y == INF) ? "INF" : to_string(r_y)) << "\n");
-                if (r_y != INF) {
-                    interval1_start = max(interval1_start, r_y + 1);
-                }
-            }
+            int interval1_start = B.empty() ? -1 : rankers.maxY(j_2, B) + 1;
+            debug(cout << "  - max over B of getY(" << j_2 << ") + 1 = " << interval1_start << "\n");
 
-            debug(cout << "  -> After max with node_i->children.start = " << node_i->children.start << "\n");
-            interval1_start = max(node_i->children.start, interval1_start);
-            int interval1_end = min(node_i->children.end, j_2);
+            debug(cout << "  -> After max with chld(i).start = " << x_tree.children[node_i].start << "\n");
+            interval1_start = max(x_tree.children[node_i].start, interval1_start);
+            int interval1_end = min(x_tree.children[node_i].end, j_2);
 
             Interval interval1(interval1_start, interval1_end);
             debug(cout << "  => Final interval1 = [" << interval1.start << ", " << interval1.end << "]\n");
@@ -304,11 +242,11 @@ vector<MatchSimK::triple> MatchSimK::matchSimK(const string& text, const string&
             // line 25: interval2 <- [j_1, min_{σ in A}{R_X(T', j_1, σ)-1}]
             debug(cout << "[interval2] Computing from A and getX(j_1 = " << j_1 << ")\n");
 
-            int interval2_end = sub_T.end - offset;
-            for (char sigma : A) {
-                int r_x = rankers.getX(j_1, sigma);
-                debug(cout << "  - A contains '" << sigma << "', getX(" << j_1 << ", '" << sigma << "') = " 
-                            << ((r_x == INF) ? "INF" : to_string(r_x)) << "\n");
+            int interval2_end = sub_T_string.size();
+            if (!A.empty()) {
+                int r_x = rankers.minX(j_1, A);
+                debug(cout << "  - min over A of getX(" << j_1 << ") = " << ((r_x == INF) ? "INF" : to_string(r_x))
+                           << "\n");
                 interval2_end = min(interval2_end, r_x - 1);
             }
 
@@ -322,22 +260,107 @@ vector<MatchSimK::triple> MatchSimK::matchSimK(const string& text, const string&
                         << "offset = " << offset << "\n\n");
         }
     }
+}  // namespace
+
+/**
+ * MatchSimK 알고리즘 구현
+ */
+vector<MatchSimK::triple> MatchSimK::matchSimK(const string& text, const string& pattern, int k) {
+    // line 1: Given: a pattern p, a text T, an integer k
+    PatternInfo info = preprocessPattern(pattern, k);
+
+    debug(cout << "Computing MatchSimK..." << endl);
+
+    // line 2: Returns: a set S of tripes where, for space positions f and b of T,
+    // T[f : b] ~k p if and only if there exists some element e = ([f_1, f_2], [b_1, b_2], offset) in S
+    // such that space positions f - offset \in [f_1, f_2] and b - offset \in [b_1, b_2]
+
+    // line 3: positions <- empty set
+    vector<triple> positions;
+
+    // line 5: Slice T whenever T[i] \not-in alph(p)
+    vector<Interval> sub_Ts;
+    int start = 0;
+    int end = 0;
+    for (char t : text) {
+        if (info.alph_p.count(t) == 0) {
+            if (start < end) sub_Ts.emplace_back(start, end);
+            end++;
+            start = end;
+            continue;
+        }
+        end++;
+    }
+    if (start < end) {
+        sub_Ts.emplace_back(start, end);
+    }
+
+    // line 8: for all sliced substrings T' of T do
+    for (Interval sub_T : sub_Ts) {
+        string sub_T_string = text.substr(sub_T.start, sub_T.end - sub_T.start);
+        debug(cout << "For sub_T string: " << sub_T_string << endl);
+
+        // line 9: offset <- the start space position of T' in T
+        int offset = sub_T.start;
+
+        // line 11: Preprocess X- and Y-ranker array
+        RankerTable rankers = RankerTable(sub_T_string);
+        rankers.buildXRankerTable();
+        rankers.buildYRankerTable();
+
+        // line 12: Construct X-tree T_X(T') and Y-tree T_Y(T')
+        auto [x_tree, y_tree] = XYTree::buildXYTrees(rankers, info.shortlex_p, sub_T_string);
+
+        matchSubText(info, k, sub_T_string, offset, rankers, x_tree, y_tree, positions);
+    }
 
     // line 27: return positions
     return positions;
 }
 
-string MatchSimK::shortlex_with_checkpoint(
+/**
+ * MatchSimK over a prebuilt TextIndex: the slicing (line 5), the rankers (line 11) and the tree parents
+ * come from the index instead of being recomputed.
+ */
+vector<MatchSimK::triple> MatchSimK::matchSimK(const TextIndex& index, const string& pattern, int k) {
+    PatternInfo info = preprocessPattern(pattern, k);
+    if (string(info.alph_p.begin(), info.alph_p.end()) != index.getAlphabet()) {
+        throw invalid_argument("matchSimK: alph(p) differs from the alphabet of the text index");
+    }
+
+    vector<triple> positions;
+
+    for (int s = 0; s < index.segmentCount(); s++) {
+        string sub_T_string = index.segmentText(s);
+        int offset = index.segment(s).start;
+
+        RankerTable rankers = index.rankers(s);
+
+        auto [x_tree, y_tree] = XYTree::buildXYTrees(
+            rankers, info.shortlex_p, sub_T_string, 0, index.xTreeParents(s), index.yTreeParents(s));
+
+        matchSubText(info, k, sub_T_string, offset, rankers, x_tree, y_tree, positions);
+    }
+
+    return positions;
+}
+
+vector<const MatchSimK::CheckPoint*> MatchSimK::link_checkpoints(
     int k,
     int pattern_universality,
     const string& sub_T_string,
     vector<vector<MatchSimK::CheckPoint>>& check_points,
     const vector<int>& x_arch_indexes,
-    const vector<int>& y_arch_indexes
+    const vector<int>& y_arch_indexes,
+    ShortlexWorkspace& workspace
 ) {
-    vector<string> partial_shortlex_z(2 * pattern_universality + 1);
-    vector<vector<int>> x_vectors(pattern_universality + 1);
-    vector<vector<int>> y_vectors(pattern_universality + 1);
+    // (start of the link, position in check_points[start]) of every piece of z: indexes rather than pointers,
+    // since saving a checkpoint may move the others
+    vector<pair<int, int>> pieces(2 * pattern_universality + 1);
+    auto checkpoint = [&](int piece) -> const MatchSimK::CheckPoint& {
+        return check_points[pieces[piece].first][pieces[piece].second];
+    };
+    const vector<int> ones(Alphabet::getInstance().size(), 1);
 
     debug(cout << "\nTargeting minimal candidate: ["
                 <<  x_arch_indexes[0] << ", " << x_arch_indexes[pattern_universality]
@@ -352,14 +375,13 @@ string MatchSimK::shortlex_with_checkpoint(
 
         bool found = false;
 
-        for (const MatchSimK::CheckPoint& cp : check_points[x_val]) {
+        for (int c = 0; c < static_cast<int>(check_points[x_val].size()); c++) {
+            const MatchSimK::CheckPoint& cp = check_points[x_val][c];
             if(i == 0 || i == pattern_universality) break; // Skip getting info
 
             if (cp.link.end != y_val) continue;
 
-            partial_shortlex_z[2 * i] = cp.partial_shortlex;
-            x_vectors[i] = cp.x_vector;
-            y_vectors[i] = cp.y_vector;
+            pieces[2 * i] = {x_val, c};
 
             debug(cout << "[YX-link FOUND] i = " << i
                         << ", Interval = (" << x_val << ", " << y_val << ")"
@@ -376,26 +398,27 @@ string MatchSimK::shortlex_with_checkpoint(
 
             int threshold = k + 1 - pattern_universality;
             debug(cout <<  "threshold: " << threshold << endl);
-            ShortlexResult partialShortlex = computePartialShortlexNormalForm(
-                sub_T_string.substr(x_val, y_val - x_val),
-                vector<int>(Alphabet::getInstance().size(), 1),
-                vector<int>(Alphabet::getInstance().size(), 1),
-                k + 1 - pattern_universality
+            ShortlexResult partialShortlex;
+            computePartialShortlexNormalForm(
+                string_view(sub_T_string).substr(x_val, y_val - x_val),
+                ones,
+                ones,
+                threshold,
+                workspace,
+                partialShortlex
             );
 
-            partial_shortlex_z[2 * i] = partialShortlex.shortlexNormalForm;
-
+            pieces[2 * i] = {x_val, static_cast<int>(check_points[x_val].size())};
             check_points[x_val].emplace_back(
                 yx_link,
                 partialShortlex.shortlexNormalForm,
+                partialShortlex.fingerprint,
                 partialShortlex.X_vector,
                 partialShortlex.Y_vector
                 );
-            x_vectors[i] = partialShortlex.X_vector;
-            y_vectors[i] = partialShortlex.Y_vector;
 
-            debug(printVector(x_vectors[i], "X_vector"));
-            debug(printVector(y_vectors[i], "Y_vector"));
+            debug(printVector(partialShortlex.X_vector, "X_vector"));
+            debug(printVector(partialShortlex.Y_vector, "Y_vector"));
 
             debug(cout << "[YX-link COMPUTED] i = " << i
                         << ", Computed ShortLex = " << partialShortlex.shortlexNormalForm << endl);
@@ -411,11 +434,12 @@ string MatchSimK::shortlex_with_checkpoint(
 
         bool found = false;
 
-        for (const MatchSimK::CheckPoint& cp : check_points[x_val]) {
+        for (int c = 0; c < static_cast<int>(check_points[x_val].size()); c++) {
+            const MatchSimK::CheckPoint& cp = check_points[x_val][c];
             if(i == 0 || i == pattern_universality - 1) break; // Skip getting info from cp
 
             if (cp.link.end == y_val) {
-                partial_shortlex_z[2 * i + 1] = cp.partial_shortlex;
+                pieces[2 * i + 1] = {x_val, c};
 
                 debug(cout << "[XY-link FOUND] i = " << i
                             << ", Interval = (" << x_val << ", " << y_val << ")"
@@ -427,10 +451,9 @@ string MatchSimK::shortlex_with_checkpoint(
         }
 
         if (!found) {
-            vector<int> x_vector =
-                (i == 0) ? vector<int>(Alphabet::getInstance().size(), 1) : x_vectors[i];
-            vector<int> y_vector =
-                (i == pattern_universality - 1) ? vector<int>(Alphabet::getInstance().size(), 1) : y_vectors[i + 1];
+            // X-vector after YX-link i and Y-vector before YX-link i + 1
+            const vector<int>& x_vector = (i == 0) ? ones : checkpoint(2 * i).x_vector;
+            const vector<int>& y_vector = (i == pattern_universality - 1) ? ones : checkpoint(2 * i + 2).y_vector;
 
             debug(cout << "[XY-link COMPUTE] i = " << i
                         << ", Will compute shortlex for substring [" << x_val << ", " << y_val << "]"
@@ -439,28 +462,71 @@ string MatchSimK::shortlex_with_checkpoint(
             debug(printVector(x_vector, "X_vector"));
             debug(printVector(y_vector, "Y_vector"));
 
-            ShortlexResult partialShortlex = computePartialShortlexNormalForm(
-                sub_T_string.substr(x_val, y_val - x_val),
+            ShortlexResult partialShortlex;
+            computePartialShortlexNormalForm(
+                string_view(sub_T_string).substr(x_val, y_val - x_val),
                 x_vector,
                 y_vector,
-                k + 2 - pattern_universality
+                k + 2 - pattern_universality,
+                workspace,
+                partialShortlex
             );
 
-            partial_shortlex_z[2 * i + 1] = partialShortlex.shortlexNormalForm;
-
-            check_points[x_val].emplace_back(xy_link, partialShortlex.shortlexNormalForm);
+            pieces[2 * i + 1] = {x_val, static_cast<int>(check_points[x_val].size())};
+            check_points[x_val].emplace_back(xy_link, partialShortlex.shortlexNormalForm, partialShortlex.fingerprint);
 
             debug(cout << "[XY-link COMPUTED] i = " << i
                         << ", Computed ShortLex = " << partialShortlex.shortlexNormalForm << endl);
         }
     }
 
+    vector<const MatchSimK::CheckPoint*> z_pieces;
+    z_pieces.reserve(pieces.size());
+    for (int piece = 0; piece < static_cast<int>(pieces.size()); piece++) {
+        z_pieces.push_back(&checkpoint(piece));
+    }
+    return z_pieces;
+}
+
+bool MatchSimK::matches_shortlex(
+    const vector<const MatchSimK::CheckPoint*>& z_pieces,
+    const ShortlexResult& shortlex_p
+) {
+    Fingerprint z_fingerprint;
+    for (const MatchSimK::CheckPoint* piece : z_pieces) {
+        z_fingerprint += piece->fingerprint;
+    }
+    if (z_fingerprint != shortlex_p.fingerprint) return false;
+
+    // fingerprints match: confirm piece by piece against the normal form of p
+    const string& p = shortlex_p.shortlexNormalForm;
+    size_t position = 0;
+    for (const MatchSimK::CheckPoint* piece : z_pieces) {
+        if (p.compare(position, piece->partial_shortlex.size(), piece->partial_shortlex) != 0) return false;
+        position += piece->partial_shortlex.size();
+    }
+    debug(cout << "[Final Z Matched] = " << p << endl << endl);
+    return position == p.size();
+}
+
+string MatchSimK::shortlex_with_checkpoint(
+    int k,
+    int pattern_universality,
+    const string& sub_T_string,
+    vector<vector<MatchSimK::CheckPoint>>& check_points,
+    const vector<int>& x_arch_indexes,
+    const vector<int>& y_arch_indexes,
+    ShortlexWorkspace& workspace
+) {
+    vector<const MatchSimK::CheckPoint*> z_pieces = link_checkpoints(
+        k, pattern_universality, sub_T_string, check_points, x_arch_indexes, y_arch_indexes, workspace);
+
     // finally, combine
     string z;
-    for (const string& part : partial_shortlex_z) {
-        z += part;
+    for (const MatchSimK::CheckPoint* piece : z_pieces) {
+        z += piece->partial_shortlex;
     }
     debug(cout << "[Final Z Combined String] = " << z << endl << endl);
 
     return z;
-}
\ No newline at end of file
+}
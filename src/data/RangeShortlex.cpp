@@ -0,0 +1,46 @@
+#include "data/RangeShortlex.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+RangeShortlex::RangeShortlex(string text, int k) : text(move(text)), k(k) {
+    int n = this->text.size();
+    blocks = (n + BLOCK - 1) / BLOCK;
+    nodes.resize(2 * blocks);
+
+    string_view letters(this->text);
+    for (int i = 0; i < blocks; i++) {
+        computeShortlexNormalForm(letters.substr(i * BLOCK, BLOCK), k, workspace, nodes[blocks + i]);
+    }
+    for (int i = blocks - 1; i >= 1; i--) {
+        scratch.assign(nodes[2 * i]);
+        scratch += nodes[2 * i + 1];
+        computeShortlexNormalForm(scratch, k, workspace, nodes[i]);
+    }
+}
+
+const string &RangeShortlex::normalForm(int begin, int end) {
+    if (begin < 0 || begin > end || end > size()) throw out_of_range("RangeShortlex: invalid range");
+
+    string_view letters(text);
+    int firstBlock = (begin + BLOCK - 1) / BLOCK;  // blocks [firstBlock, lastBlock) lie inside the range
+    int lastBlock = end / BLOCK;
+    if (firstBlock >= lastBlock) {
+        computeShortlexNormalForm(letters.substr(begin, end - begin), k, workspace, current);
+        return current;
+    }
+
+    // head letters, then the covering nodes from left to right, then tail letters
+    scratch.assign(letters.substr(begin, firstBlock * BLOCK - begin));
+    rightNodes.clear();
+    for (int low = firstBlock + blocks, high = lastBlock + blocks; low < high; low /= 2, high /= 2) {
+        if (low & 1) scratch += nodes[low++];
+        if (high & 1) rightNodes.push_back(--high);
+    }
+    for (int i = rightNodes.size() - 1; i >= 0; i--) scratch += nodes[rightNodes[i]];
+    scratch += letters.substr(lastBlock * BLOCK, end - lastBlock * BLOCK);
+
+    computeShortlexNormalForm(scratch, k, workspace, current);
+    return current;
+}
@@ -1,55 +1,515 @@
 #include "data/Ranker.h"
 
+#include <algorithm>
+#include <cstring>
+#include <exception>
 #include <limits>
 #include <stdexcept>
+#include <thread>
 
 #include "utils/Alphabet.h"
 #include "utils/Common.h"
+#include "utils/Parallel.h"
 
-RankerTable::RankerTable(const std::string &text) : text(text) {
+namespace {
+    template <typename Cell>
+    constexpr Cell INF_CELL = std::numeric_limits<Cell>::max();
+
+    template <typename Cell>
+    inline int decodeX(Cell cell) {
+        return cell == INF_CELL<Cell> ? INF : static_cast<int>(cell);
+    }
+
+    template <typename Cell>
+    inline int decodeY(Cell cell) {
+        return static_cast<int>(cell) - 1;
+    }
+
+    // Cell encodings are monotone, so reducing raw cells and decoding afterwards gives the reduced rank.
+    // The full-row loop runs over contiguous memory and is vectorized by the compiler.
+    template <typename Cell, bool IsMax>
+    Cell reduceRow(const Cell *row, int width, const SymbolMask &symbols, bool full) {
+        Cell result = IsMax ? 0 : INF_CELL<Cell>;
+        if (full) {
+            for (int c = 0; c < width; ++c) result = IsMax ? std::max(result, row[c]) : std::min(result, row[c]);
+        } else {
+            symbols.forEach([&](int c) { result = IsMax ? std::max(result, row[c]) : std::min(result, row[c]); });
+        }
+        return result;
+    }
+}  // namespace
+
+RankerTable::RankerTable(const std::string &text, Backend backend) : text(text), backend(backend) {
     int n = text.size();
-    int alphabetSize = Alphabet::getInstance().size();
+    width = Alphabet::getInstance().size();
+    allSymbols = SymbolMask::firstN(width);
+
+    // X-ranks go up to n and Y-ranks are stored shifted by one, so n must stay below the INF cell value.
+    narrow = n < INF_CELL<uint16_t>;
+
+    size_t cells = static_cast<size_t>(n + 1) * width;
+    if (backend == Backend::Auto) {
+        size_t tableBytes = 2 * cells * (narrow ? sizeof(uint16_t) : sizeof(uint32_t));
+        this->backend = tableBytes > AUTO_TABLE_LIMIT ? Backend::Occurrence : Backend::Table;
+    }
+
+    if (this->backend == Backend::Occurrence) {
+        occurrences.assign(width, std::vector<int>());
+    } else if (narrow) {
+        xTable16.assign(cells, INF_CELL<uint16_t>);
+        yTable16.assign(cells, 0);
+    } else {
+        xTable32.assign(cells, INF_CELL<uint32_t>);
+        yTable32.assign(cells, 0);
+    }
+    pointAtOwnedTables();
+}
+
+RankerTable::RankerTable(const std::string &text, const uint32_t *xCells, const uint32_t *yCells)
+    : text(text), backend(Backend::Table), narrow(false), xCells(xCells), yCells(yCells) {
+    width = Alphabet::getInstance().size();
+    allSymbols = SymbolMask::firstN(width);
+}
 
-    xTable.assign(n + 1, std::vector<int>(alphabetSize, INF));
-    yTable.assign(n + 1, std::vector<int>(alphabetSize, -1));
+RankerTable::RankerTable(const RankerTable &other) { *this = other; }
+
+RankerTable &RankerTable::operator=(const RankerTable &other) {
+    text = other.text;
+    backend = other.backend;
+    width = other.width;
+    narrow = other.narrow;
+    allSymbols = other.allSymbols;
+    xTable16 = other.xTable16;
+    yTable16 = other.yTable16;
+    xTable32 = other.xTable32;
+    yTable32 = other.yTable32;
+    occurrences = other.occurrences;
+    occurrencesBuilt = other.occurrencesBuilt;
+    xBuilt = other.xBuilt;
+    xPatchFrom = other.xPatchFrom;
+    pendingX = other.pendingX;
+    pendingXCount = other.pendingXCount;
+    xCells = other.xCells;
+    yCells = other.yCells;
+    pointAtOwnedTables();
+    return *this;
+}
+
+// Owned tables have to be re-pointed after every copy; external cells are shared as they are.
+void RankerTable::pointAtOwnedTables() {
+    if (!xTable16.empty()) {
+        xCells = xTable16.data();
+        yCells = yTable16.data();
+    } else if (!xTable32.empty()) {
+        xCells = xTable32.data();
+        yCells = yTable32.data();
+    }
 }
 
-void RankerTable::buildXRankerTable() {
+/**
+ * @brief Scans the text right-to-left keeping the next occurrence of every char,
+ * and copies that vector as a whole into each row.
+ *
+ * With several threads every chunk of rows is scanned on its own, starting from an all-INF vector.
+ * A cell then only differs from the serial build if it is INF while c occurs after the chunk; such cells
+ * form a run at the end of the chunk per char and are filled with the first occurrence of c after the chunk.
+ */
+template <typename Cell>
+void RankerTable::fillXRows(std::vector<Cell> &table, int threads) {
     int n = text.size();
-    int alphabetSize = Alphabet::getInstance().size();
 
-    std::vector<int> next(alphabetSize, INF);
+    if (threads <= 0) threads = defaultThreadCount();
+    std::vector<std::vector<Cell>> chunkFirst(threads);  // next-vector at the first row of each chunk
+    std::vector<int> chunkBegin(threads), chunkEnd(threads);
 
-    for (int i = n - 1; i >= 0; --i) {
-        int charIndex = Alphabet::getInstance().charToIndex(text[i]);
-        next[charIndex] = i + 1;
-        for (int c = 0; c < alphabetSize; ++c) {
-            xTable[i][c] = next[c];
+    int chunks = parallelChunks(0, n, threads, [&](int begin, int end, int chunk) {
+        std::vector<Cell> next(width, INF_CELL<Cell>);
+
+        for (int i = end - 1; i >= begin; --i) {
+            int charIndex = Alphabet::getInstance().charToIndex(text[i]);
+            next[charIndex] = static_cast<Cell>(i + 1);
+            std::memcpy(&table[static_cast<size_t>(i) * width], next.data(), width * sizeof(Cell));
+        }
+        chunkFirst[chunk] = std::move(next);
+        chunkBegin[chunk] = begin;
+        chunkEnd[chunk] = end;
+    });
+    if (chunks == 1) return;
+
+    // after[chunk]: true next-vector at the row right after the chunk, folded from the last chunk backwards
+    std::vector<std::vector<Cell>> after(chunks, std::vector<Cell>(width, INF_CELL<Cell>));
+    for (int chunk = chunks - 2; chunk >= 0; --chunk) {
+        for (int c = 0; c < width; ++c) {
+            Cell first = chunkFirst[chunk + 1][c];
+            after[chunk][c] = first != INF_CELL<Cell> ? first : after[chunk + 1][c];
         }
     }
+
+    parallelChunks(0, chunks - 1, chunks - 1, [&](int begin, int end, int) {
+        for (int chunk = begin; chunk < end; ++chunk) {
+            for (int c = 0; c < width; ++c) {
+                if (after[chunk][c] == INF_CELL<Cell>) continue;
+                for (int i = chunkEnd[chunk] - 1; i >= chunkBegin[chunk]; --i) {
+                    Cell &cell = table[static_cast<size_t>(i) * width + c];
+                    if (cell != INF_CELL<Cell>) break;
+                    cell = after[chunk][c];
+                }
+            }
+        }
+    });
 }
 
-void RankerTable::buildYRankerTable() {
+/**
+ * @brief Scans the text left-to-right keeping the previous occurrence (+1) of every char,
+ * and copies that vector as a whole into each row.
+ *
+ * Mirrors fillXRows: chunks start from an all-0 (= -1) vector, and the run of 0 cells at the start of
+ * a chunk is filled with the last occurrence of c before the chunk.
+ */
+template <typename Cell>
+void RankerTable::fillYRows(std::vector<Cell> &table, int threads) {
     int n = text.size();
-    int alphabetSize = Alphabet::getInstance().size();
 
-    std::vector<int> prev(alphabetSize, -1);
+    if (threads <= 0) threads = defaultThreadCount();
+    std::vector<std::vector<Cell>> chunkLast(threads);  // prev-vector at the last row of each chunk
+    std::vector<int> chunkBegin(threads), chunkEnd(threads);
+
+    int chunks = parallelChunks(0, n, threads, [&](int begin, int end, int chunk) {
+        std::vector<Cell> prev(width, 0);
+
+        for (int i = begin; i < end; ++i) {
+            int charIndex = Alphabet::getInstance().charToIndex(text[i]);
+            prev[charIndex] = static_cast<Cell>(i + 1);
+            std::memcpy(&table[static_cast<size_t>(i + 1) * width], prev.data(), width * sizeof(Cell));
+        }
+        chunkLast[chunk] = std::move(prev);
+        chunkBegin[chunk] = begin;
+        chunkEnd[chunk] = end;
+    });
+    if (chunks == 1) return;
+
+    // before[chunk]: true prev-vector at the row right before the chunk, folded from the first chunk forwards
+    std::vector<std::vector<Cell>> before(chunks, std::vector<Cell>(width, 0));
+    for (int chunk = 1; chunk < chunks; ++chunk) {
+        for (int c = 0; c < width; ++c) {
+            Cell last = chunkLast[chunk - 1][c];
+            before[chunk][c] = last != 0 ? last : before[chunk - 1][c];
+        }
+    }
 
+    parallelChunks(1, chunks, chunks - 1, [&](int begin, int end, int) {
+        for (int chunk = begin; chunk < end; ++chunk) {
+            for (int c = 0; c < width; ++c) {
+                if (before[chunk][c] == 0) continue;
+                for (int i = chunkBegin[chunk]; i < chunkEnd[chunk]; ++i) {
+                    Cell &cell = table[static_cast<size_t>(i + 1) * width + c];
+                    if (cell != 0) break;
+                    cell = before[chunk][c];
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Collects the ascending positions of every char. Both directions answer from these lists,
+ * so building either ranker builds the lists once.
+ */
+void RankerTable::buildOccurrences() {
+    int n = text.size();
+
+    if (occurrencesBuilt) return;
+
+    std::vector<int> counts(width, 0);
+    for (char c : text) counts[Alphabet::getInstance().charToIndex(c)]++;
+    for (int c = 0; c < width; ++c) occurrences[c].reserve(counts[c]);
+
+    for (int i = 0; i < n; ++i) {
+        occurrences[Alphabet::getInstance().charToIndex(text[i])].push_back(i);
+    }
+    occurrencesBuilt = true;
+}
+
+void RankerTable::buildXRankerTable(int threads) {
+    if (backend == Backend::Occurrence) {
+        buildOccurrences();
+        return;
+    }
+
+    if (narrow)
+        fillXRows(xTable16, threads);
+    else
+        fillXRows(xTable32, threads);
+
+    // rows after the last occurrence of c hold INF for c until c gets appended
+    int n = text.size();
+    xPatchFrom.assign(width, 0);
     for (int i = 0; i < n; ++i) {
-        int charIndex = Alphabet::getInstance().charToIndex(text[i]);
-        prev[charIndex] = i;
-        for (int c = 0; c < alphabetSize; ++c) {
-            yTable[i + 1][c] = prev[c];
+        xPatchFrom[Alphabet::getInstance().charToIndex(text[i])] = i + 1;
+    }
+    pendingX.assign(width, std::vector<int>());
+    pendingXCount = 0;
+    xBuilt = true;
+}
+
+void RankerTable::buildYRankerTable(int threads) {
+    if (backend == Backend::Occurrence)
+        buildOccurrences();
+    else if (narrow)
+        fillYRows(yTable16, threads);
+    else
+        fillYRows(yTable32, threads);
+}
+
+void RankerTable::buildRankerTables(int threads) {
+    // both directions share the occurrence lists, which are built once
+    if (backend == Backend::Occurrence) {
+        buildOccurrences();
+        return;
+    }
+
+    if (threads <= 0) threads = defaultThreadCount();
+    if (threads == 1) {
+        buildXRankerTable(1);
+        buildYRankerTable(1);
+        return;
+    }
+
+    // the two directions write disjoint members; a failure on either side is rethrown after both joined
+    std::exception_ptr yFailure;
+    std::thread yBuilder([this, threads, &yFailure] {
+        try {
+            buildYRankerTable(threads / 2);
+        } catch (...) {
+            yFailure = std::current_exception();
         }
+    });
+    try {
+        buildXRankerTable(threads - threads / 2);
+    } catch (...) {
+        yBuilder.join();
+        throw;
     }
+    yBuilder.join();
+    if (yFailure) std::rethrow_exception(yFailure);
 }
 
-int RankerTable::getX(int index, char c) const {
+/**
+ * @brief Adds the rows of a newly appended char: the new Y-row is the previous one with `charIndex` moved to
+ * the new position, and the new X-row is all INF since nothing follows the end of the text yet.
+ */
+template <typename Cell>
+void RankerTable::appendRows(std::vector<Cell> &xTable, std::vector<Cell> &yTable, int charIndex) {
+    size_t row = text.size();  // text already holds the new char
+
+    xTable.resize(xTable.size() + width, INF_CELL<Cell>);
+    yTable.resize(yTable.size() + width);
+    std::memcpy(&yTable[row * width], &yTable[(row - 1) * width], width * sizeof(Cell));
+    yTable[row * width + charIndex] = static_cast<Cell>(row);  // previous occurrence is row - 1, stored +1
+}
+
+/**
+ * @brief Writes the pending appended positions into the X-cells that were INF for their char.
+ * Rows are walked from xPatchFrom[c] up to each appended position, so every cell is written once.
+ */
+template <typename Cell>
+void RankerTable::patchX(std::vector<Cell> &xTable) {
+    for (int c = 0; c < width; ++c) {
+        for (int position : pendingX[c]) {
+            for (int row = xPatchFrom[c]; row <= position; ++row) {
+                xTable[static_cast<size_t>(row) * width + c] = static_cast<Cell>(position + 1);
+            }
+            xPatchFrom[c] = position + 1;
+        }
+        pendingX[c].clear();
+    }
+}
+
+// Converts uint16_t cells to uint32_t once the text outgrows them
+void RankerTable::widen() {
+    xTable32.resize(xTable16.size());
+    yTable32.resize(yTable16.size());
+    for (size_t i = 0; i < xTable16.size(); ++i) {
+        xTable32[i] = xTable16[i] == INF_CELL<uint16_t> ? INF_CELL<uint32_t> : xTable16[i];
+        yTable32[i] = yTable16[i];
+    }
+    std::vector<uint16_t>().swap(xTable16);
+    std::vector<uint16_t>().swap(yTable16);
+    narrow = false;
+}
+
+void RankerTable::append(char c) {
+    if (backend == Backend::Table && xTable16.empty() && xTable32.empty()) {
+        throw std::logic_error("RankerTable: cannot append to external cells");
+    }
+
+    int n = text.size();
     int charIndex = Alphabet::getInstance().charToIndex(c);
-    return xTable[index][charIndex];
+    text += c;
+
+    if (backend == Backend::Occurrence) {
+        if (occurrencesBuilt) occurrences[charIndex].push_back(n);
+        return;
+    }
+
+    if (narrow && n + 1 >= INF_CELL<uint16_t>) widen();
+
+    if (narrow)
+        appendRows(xTable16, yTable16, charIndex);
+    else
+        appendRows(xTable32, yTable32, charIndex);
+    pointAtOwnedTables();
+
+    if (xBuilt) {
+        pendingX[charIndex].push_back(n);
+        pendingXCount++;
+    }
+}
+
+void RankerTable::append(const std::string &chunk) {
+    for (char c : chunk) append(c);
+}
+
+void RankerTable::flushPendingX() {
+    if (!xBuilt) return;
+
+    if (narrow)
+        patchX(xTable16);
+    else
+        patchX(xTable32);
+    pendingXCount = 0;
+}
+
+int RankerTable::getX(int index, char c) const {
+    return getXByIndex(index, Alphabet::getInstance().charToIndex(c));
 }
 
 int RankerTable::getY(int index, char c) const {
-    int charIndex = Alphabet::getInstance().charToIndex(c);
-    return yTable[index][charIndex];
+    return getYByIndex(index, Alphabet::getInstance().charToIndex(c));
+}
+
+int RankerTable::getXByIndex(int index, int charIndex) const {
+    if (backend == Backend::Occurrence) {
+        // first occurrence at or after index
+        const std::vector<int> &positions = occurrences[charIndex];
+        auto it = std::lower_bound(positions.begin(), positions.end(), index);
+        return it == positions.end() ? INF : *it + 1;
+    }
+
+    size_t cell = static_cast<size_t>(index) * width + charIndex;
+    int rank = narrow ? decodeX(static_cast<const uint16_t *>(xCells)[cell])
+                      : decodeX(static_cast<const uint32_t *>(xCells)[cell]);
+
+    // INF may still be waiting for a pending append of c
+    if (rank == INF && xBuilt && !pendingX[charIndex].empty()) {
+        auto it = std::lower_bound(pendingX[charIndex].begin(), pendingX[charIndex].end(), index);
+        if (it != pendingX[charIndex].end()) rank = *it + 1;
+    }
+    return rank;
+}
+
+int RankerTable::getYByIndex(int index, int charIndex) const {
+    if (backend == Backend::Occurrence) {
+        // last occurrence strictly before index
+        const std::vector<int> &positions = occurrences[charIndex];
+        auto it = std::lower_bound(positions.begin(), positions.end(), index);
+        return it == positions.begin() ? -1 : *(it - 1);
+    }
+
+    size_t cell = static_cast<size_t>(index) * width + charIndex;
+    return narrow ? decodeY(static_cast<const uint16_t *>(yCells)[cell])
+                  : decodeY(static_cast<const uint32_t *>(yCells)[cell]);
+}
+
+template <bool IsMax>
+int RankerTable::reduceX(int index, const SymbolMask &symbols) const {
+    if (symbols.empty()) return IsMax ? -1 : INF;
+
+    // cells may be stale while appends are pending; answer per char then
+    if (backend == Backend::Occurrence || pendingXCount > 0) {
+        int result = IsMax ? -1 : INF;
+        symbols.forEach([&](int c) {
+            int rank = getXByIndex(index, c);
+            result = IsMax ? std::max(result, rank) : std::min(result, rank);
+        });
+        return result;
+    }
+
+    size_t row = static_cast<size_t>(index) * width;
+    bool full = symbols == allSymbols;
+    return narrow ? decodeX(reduceRow<uint16_t, IsMax>(static_cast<const uint16_t *>(xCells) + row, width, symbols, full))
+                  : decodeX(reduceRow<uint32_t, IsMax>(static_cast<const uint32_t *>(xCells) + row, width, symbols, full));
+}
+
+template <bool IsMax>
+int RankerTable::reduceY(int index, const SymbolMask &symbols) const {
+    if (symbols.empty()) return IsMax ? -1 : INF;
+
+    if (backend == Backend::Occurrence) {
+        int result = IsMax ? -1 : INF;
+        symbols.forEach([&](int c) {
+            int rank = getYByIndex(index, c);
+            result = IsMax ? std::max(result, rank) : std::min(result, rank);
+        });
+        return result;
+    }
+
+    size_t row = static_cast<size_t>(index) * width;
+    bool full = symbols == allSymbols;
+    return narrow ? decodeY(reduceRow<uint16_t, IsMax>(static_cast<const uint16_t *>(yCells) + row, width, symbols, full))
+                  : decodeY(reduceRow<uint32_t, IsMax>(static_cast<const uint32_t *>(yCells) + row, width, symbols, full));
+}
+
+int RankerTable::maxX(int index, const SymbolMask &symbols) const { return reduceX<true>(index, symbols); }
+
+int RankerTable::minX(int index, const SymbolMask &symbols) const { return reduceX<false>(index, symbols); }
+
+int RankerTable::maxY(int index, const SymbolMask &symbols) const { return reduceY<true>(index, symbols); }
+
+int RankerTable::minY(int index, const SymbolMask &symbols) const { return reduceY<false>(index, symbols); }
+
+void RankerTable::gatherX(int index, const SymbolMask &symbols, int *out) const {
+    symbols.forEach([&](int c) { *out++ = getXByIndex(index, c); });
+}
+
+void RankerTable::gatherY(int index, const SymbolMask &symbols, int *out) const {
+    symbols.forEach([&](int c) { *out++ = getYByIndex(index, c); });
+}
+
+void RankerTable::maxX(int begin, int end, const SymbolMask &symbols, int *out) const {
+    for (int i = begin; i < end; ++i) *out++ = reduceX<true>(i, symbols);
+}
+
+void RankerTable::minY(int begin, int end, const SymbolMask &symbols, int *out) const {
+    for (int i = begin; i < end; ++i) *out++ = reduceY<false>(i, symbols);
+}
+
+size_t RankerTable::memoryUsage() const {
+    size_t occurrenceBytes = 0;
+    for (const auto &positions : occurrences) occurrenceBytes += positions.capacity() * sizeof(int);
+
+    return occurrenceBytes + (xTable16.size() + yTable16.size()) * sizeof(uint16_t) +
+           (xTable32.size() + yTable32.size()) * sizeof(uint32_t);
+}
+
+// uint32_t cells are copied as they are; uint16_t cells only need INF widened, as in widen()
+void RankerTable::copyXCells(size_t from, size_t count, uint32_t *out) const {
+    if (backend != Backend::Table || pendingXCount > 0)
+        throw std::logic_error("RankerTable: no flat X-cells to copy");
+    if (!narrow) {
+        std::memcpy(out, static_cast<const uint32_t *>(xCells) + from, count * sizeof(uint32_t));
+        return;
+    }
+    const uint16_t *cells = static_cast<const uint16_t *>(xCells) + from;
+    for (size_t i = 0; i < count; ++i) out[i] = cells[i] == INF_CELL<uint16_t> ? INF_CELL<uint32_t> : cells[i];
+}
+
+void RankerTable::copyYCells(size_t from, size_t count, uint32_t *out) const {
+    if (backend != Backend::Table) throw std::logic_error("RankerTable: no flat Y-cells to copy");
+    if (!narrow) {
+        std::memcpy(out, static_cast<const uint32_t *>(yCells) + from, count * sizeof(uint32_t));
+        return;
+    }
+    const uint16_t *cells = static_cast<const uint16_t *>(yCells) + from;
+    std::copy(cells, cells + count, out);
 }
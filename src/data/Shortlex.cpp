@@ -3,94 +3,548 @@
 #include <deque>
 
 #include "utils/Alphabet.h"
+#include "utils/CountingSort.h"
+#include "utils/Parallel.h"
 
 using namespace std;
 
-/**
-   * @brief Computes the shortlex normal form of w (under Simon's congruence for parameter k)
-   * 
-   * Testing Simon's congruence 논문 버전 SNF 계산 알고리즘
-  */
-string computeShortlexNormalForm(const string& w, int k) {
-    int n = w.size();
+namespace {
+    // 16 saturating 8-bit counters, used by the batch kernel (one word per lane) and the parallel X pass
+    // (one symbol per lane)
+    using LaneVector = uint8_t __attribute__((vector_size(16)));
+    constexpr int LANES = sizeof(LaneVector);
+
+    /**
+     * Counter vector C under "C[c]++, then C[j] <- min(C[j], C[c]) for all j", in O(log) per update instead of
+     * O(sigma).
+     *
+     * After an update C[c] is the largest counter, so the clamp only lowers symbols updated earlier (or never):
+     * a symbol last updated at time s holds the minimum of the values written at times >= s. Those suffix minima
+     * are kept as a monotone stack of (time, value) with increasing values, searched by time.
+     * Written values saturate at threshold + 1, which keeps every X + Y <= threshold decision (saturation commutes
+     * with the increment and the clamp) and bounds the stack by the threshold, also on long unary runs.
+     * Small alphabets keep the plain clamp loop, which is cheaper there than the search.
+     */
+    class LazyCounters {
+       public:
+        explicit LazyCounters(ShortlexWorkspace &workspace)
+            : seed(workspace.counterSeed),
+              setAt(workspace.counterSetAt),
+              capTime(workspace.capTime),
+              capValue(workspace.capValue) {}
+
+        // C <- initial, or all 1 if initial is null
+        void reset(const vector<int> *initial, int width, int threshold) {
+            if (initial != nullptr)
+                seed.assign(initial->begin(), initial->end());
+            else
+                seed.assign(width, 1);
+            setAt.assign(seed.size(), -1);
+            capTime.clear();
+            capValue.clear();
+            time = 0;
+            cap = threshold < numeric_limits<int>::max() ? threshold + 1 : threshold;
+            eager = static_cast<int>(seed.size()) <= EAGER_MAX_WIDTH;
+        }
 
-    vector<int> X(n, 0);  // X-coordinates
-    vector<int> Y(n, 0);  // Y-coordinates
+        int get(int c) const {
+            if (eager) return seed[c];
 
-    int ALPHABET_SIZE = Alphabet::getInstance().size();
+            int since = setAt[c] < 0 ? 0 : setAt[c];
 
-    string shortlexNormalForm;
-    deque<int> shortlexNormalX;  // X-coordinates of SNF
-    deque<int> shortlexNormalY;  // Y-coordinates of SNF
-
-    // 1. Compute X-coordinates from left-to-right
-    vector<int> counter(ALPHABET_SIZE, 1);
-    for (int i = 0; i < n; i++) {
-        char c = w[i];
-        int alphabetIndex = Alphabet::getInstance().charToIndex(c);
+            // recently updated symbols are near the top: gallop down from it, then binary search in (low, high]
+            int size = capTime.size();
+            int high = size, low = size - 1;
+            for (int step = 1; low >= 0 && capTime[low] >= since; step *= 2) {
+                high = low;
+                low -= step;
+            }
+            int i = lower_bound(capTime.begin() + max(low + 1, 0), capTime.begin() + high, since) - capTime.begin();
+            if (i == size) return seed[c];  // nothing written since
+            return setAt[c] < 0 ? min(seed[c], capValue[i]) : capValue[i];
+        }
 
-        X[i] = counter[alphabetIndex];
-        counter[alphabetIndex]++;
+        // C[c]++ and clamp, returns the value of C[c] before the update
+        int advance(int c) {
+            if (eager) {
+                int value = seed[c];
+                seed[c] = value < cap ? value + 1 : value;
+                for (int &counter : seed) counter = min(counter, seed[c]);
+                return value;
+            }
 
-        for (int a = 0; a < ALPHABET_SIZE; a++) {
-            counter[a] = min(counter[a], counter[alphabetIndex]);
+            int value = get(c);
+            int written = value < cap ? value + 1 : value;
+            while (!capValue.empty() && capValue.back() >= written) {
+                capTime.pop_back();
+                capValue.pop_back();
+            }
+            capTime.push_back(time);
+            capValue.push_back(written);
+            setAt[c] = time++;
+            return value;
         }
-    }
 
-    // 2. Compute Y-coordinates from right-to-left, while computing SNF and its coordinates
-    fill(counter.begin(), counter.end(), 1);  // reset counters for Y
-    for (int i = n - 1; i >= 0; i--) {
-        char c = w[i];
-        int alphabetIndex = Alphabet::getInstance().charToIndex(c);
+        void materialize(vector<int> &out) const {
+            if (eager) {
+                out.assign(seed.begin(), seed.end());
+                return;
+            }
+
+            out.resize(seed.size());
+            for (int c = 0; c < static_cast<int>(seed.size()); c++) out[c] = get(c);
+        }
 
-        // If X[i] + Y[i] is at most k+1, then we keep the letter.
-        if (X[i] + counter[alphabetIndex] <= k + 1) {
-            Y[i] = counter[alphabetIndex];
-            counter[alphabetIndex]++;
+       private:
+        vector<int> &seed;  // values before the first update (the counters themselves when eager)
+        vector<int> &setAt;
+        vector<int> &capTime;
+        vector<int> &capValue;
+        int time = 0;
+        int cap = 0;  // saturation value of written counters
+        bool eager = false;
+
+        static constexpr int EAGER_MAX_WIDTH = 16;
+    };
+
+    // -------------------- Parallel X pass --------------------
+    // Inputs shorter than this keep the serial X pass
+    constexpr int PARALLEL_MIN_LENGTH = 1 << 16;
+
+    /**
+     * @brief Step 1 split over `threads` chunks of w, for alphabets of at most LANES symbols.
+     *
+     * Only X <= threshold matters to step 2, so counters saturate at B = threshold + 1. Then one letter is a
+     * min-plus linear map of the counter vector, and so is a chunk: out[j] = min(B, min_c in[c] + M[j][c]).
+     *   1. every chunk computes its transfer matrix M (row j as a LaneVector over c), in parallel
+     *   2. the counter vectors at the chunk starts follow by a prefix scan over the matrices
+     *   3. every chunk re-runs its letters from its own start vector, in parallel
+     * Leaves saturated X-coordinates in workspace.X, alph(w) in workspace.alphabet, and the last position whose
+     * letter step 2 may keep in `last`. Returns false (doing nothing) where it does not apply.
+     */
+    bool parallelXCoordinates(string_view w,
+        const vector<int> *X_vector,
+        const vector<int> *Y_vector,
+        int threshold,
+        ShortlexWorkspace &workspace,
+        int threads,
+        int &last) {
+        int n = w.size();
+        int width = Alphabet::getInstance().size();
+        if (threads <= 0) threads = defaultThreadCount();
+        if (threads == 1 || n < PARALLEL_MIN_LENGTH || width > LANES) return false;
+        if (threshold < 0 || threshold + 1 >= UINT8_MAX) return false;
+
+        const uint8_t B = threshold + 1;
+        const LaneVector saturated = LaneVector{} + B;
+        int chunks = max(1, min(threads, n));
+
+        // 1. transfer matrices and alphabets of the chunks: like the serial pass, a letter a increments C[a] and then
+        // clamps every counter to the new C[a]
+        vector<vector<LaneVector>> transfer(chunks, vector<LaneVector>(width));
+        vector<SymbolMask> alphabets(chunks);
+        parallelChunks(0, n, threads, [&](int chunkBegin, int chunkEnd, int chunk) {
+            vector<LaneVector> &M = transfer[chunk];
+            for (int j = 0; j < width; j++) {
+                M[j] = saturated;
+                M[j][j] = 0;
+            }
+            for (int i = chunkBegin; i < chunkEnd; i++) {
+                int a = Alphabet::getInstance().charToIndex(w[i]);
+                alphabets[chunk].set(a);
+                LaneVector row = M[a] + 1;
+                row = row < saturated ? row : saturated;
+                for (LaneVector &other : M) other = other < row ? other : row;
+                M[a] = row;
+            }
+        });
+
+        // 2. counter vectors at the chunk starts
+        vector<LaneVector> start(chunks);
+        for (int c = 0; c < width; c++) start[0][c] = min<int>(X_vector != nullptr ? (*X_vector)[c] : 1, B);
+        for (int chunk = 0; chunk + 1 < chunks; chunk++) {
+            for (int j = 0; j < width; j++) {
+                int value = B;
+                for (int c = 0; c < width; c++) value = min(value, start[chunk][c] + transfer[chunk][j][c]);
+                start[chunk + 1][j] = value;
+            }
+        }
 
-            for (int a = 0; a < ALPHABET_SIZE; a++) {
-                counter[a] = min(counter[a], counter[alphabetIndex]);
+        // 3. X-coordinates, with the counters of all symbols in one vector
+        int yMin = Y_vector != nullptr ? *min_element(Y_vector->begin(), Y_vector->end()) : 1;
+        vector<int> lastLive(chunks, -1);
+        parallelChunks(0, n, threads, [&](int chunkBegin, int chunkEnd, int chunk) {
+            LaneVector counters = start[chunk];
+            for (int i = chunkBegin; i < chunkEnd; i++) {
+                int a = Alphabet::getInstance().charToIndex(w[i]);
+                int x = counters[a];
+                workspace.X[i] = x;
+                if (x + yMin <= threshold) lastLive[chunk] = i;
+
+                counters[a] = min(x + 1, static_cast<int>(B));
+                LaneVector value = LaneVector{} + counters[a];
+                counters = counters < value ? counters : value;
             }
+        });
 
-            shortlexNormalForm.insert(shortlexNormalForm.begin(), c);
-            shortlexNormalX.push_front(X[i]);
-            shortlexNormalY.push_front(Y[i]);
-        }  // otherwise, do not include the letter in SNF.
+        workspace.alphabet = SymbolMask();
+        for (const SymbolMask &alphabet : alphabets) workspace.alphabet |= alphabet;
+        last = *max_element(lastLive.begin(), lastLive.end());
+        return true;
     }
 
-    // 3. Re-compute X-coordinates based on SNF
-    int m = shortlexNormalForm.size();
-    fill(counter.begin(), counter.end(), 1);
-    for (int i = 0; i < m; i++) {
-        char c = shortlexNormalForm[i];
-        int alphabetIndex = Alphabet::getInstance().charToIndex(c);
+    // Steps 1-2: X-coordinates of w, then the letters with X + Y <= threshold written right-to-left into
+    // workspace.buffer[begin, |w|) with their Y-coordinates. Also leaves alph(w) and the new Y-vector.
+    // threads: threads of the X pass, see parallelXCoordinates
+    void keepLetters(string_view w,
+        const vector<int> *X_vector,
+        const vector<int> *Y_vector,
+        int threshold,
+        ShortlexWorkspace &workspace,
+        int threads = 1) {
+        int n = w.size();
+        int width = Alphabet::getInstance().size();
+
+        workspace.X.resize(n);
+        workspace.normalX.resize(n);
+        workspace.normalY.resize(n);
+        workspace.buffer.resize(n);
+        workspace.alphabet = SymbolMask();
+
+        LazyCounters counters(workspace);
+
+        // 1. Compute X-coordinates
+        int last = n - 1;  // letters after `last` are deleted in step 2
+        if (!parallelXCoordinates(w, X_vector, Y_vector, threshold, workspace, threads, last)) {
+            counters.reset(X_vector, width, threshold);
+            for (int i = 0; i < n; i++) {
+                int c = Alphabet::getInstance().charToIndex(w[i]);
+                workspace.X[i] = counters.advance(c);
+                workspace.alphabet.set(c);  // for detecting archs, compute alph(w)
+            }
+        }
 
-        shortlexNormalX.push_back(counter[alphabetIndex]);
-        counter[alphabetIndex]++;
+        // 2. Compute Y-coordinates and normal form, written right-to-left
+        counters.reset(Y_vector, width, threshold);
+        int begin = n;
+        for (int i = last; i >= 0; i--) {
+            int c = Alphabet::getInstance().charToIndex(w[i]);
+            int y = counters.get(c);
+
+            // If X[i] + Y[i] is at most the threshold, then we keep the letter.
+            if (workspace.X[i] + y <= threshold) {
+                counters.advance(c);
+                begin--;
+                workspace.buffer[begin] = w[i];
+                workspace.normalY[begin] = y;
+            }
+        }
+        workspace.begin = begin;
+        counters.materialize(workspace.yVector);
+    }
 
-        for (int a = 0; a < ALPHABET_SIZE; a++) {
-            counter[a] = min(counter[a], counter[alphabetIndex]);
+    // Step 3: re-computes X-coordinates based on the kept letters, which also gives the new X-vector
+    void normalXCoordinates(const vector<int> *X_vector, int threshold, ShortlexWorkspace &workspace) {
+        LazyCounters counters(workspace);
+        counters.reset(X_vector, Alphabet::getInstance().size(), threshold);
+        for (int i = workspace.begin; i < static_cast<int>(workspace.buffer.size()); i++) {
+            int c = Alphabet::getInstance().charToIndex(workspace.buffer[i]);
+            workspace.normalX[i] = counters.advance(c);
         }
+        counters.materialize(workspace.xVector);
     }
 
-    // 4. Lexicographically reorder blocks
-    // block = elements whose coordinate (X,Y) are the same
-    int start = 0;
-    while (start < m) {
+    // Step 4 for one block: sorts the block starting at `start` and returns its end.
+    // block = elements whose coordinate (X,Y) are the same, with X + Y == threshold
+    int sortBlock(ShortlexWorkspace &workspace, int start, int threshold) {
+        int n = workspace.buffer.size();
         int end = start + 1;
-        while (end < m && shortlexNormalX[end] == shortlexNormalX[start] &&
-            shortlexNormalY[end] == shortlexNormalY[start] &&
-            (shortlexNormalX[start] + shortlexNormalY[start] == k + 1)) {
+        while (end < n && workspace.normalX[end] == workspace.normalX[start] &&
+            workspace.normalY[end] == workspace.normalY[start] &&
+            (workspace.normalX[start] + workspace.normalY[start] == threshold)) {
             end++;
         }
         if (end - start > 1) {
-            // TODO: replace to custom sorting algorithm --- ex) counting sort
-            sort(shortlexNormalForm.begin() + start, shortlexNormalForm.begin() + end);
+            countingSortBlock(workspace.buffer, start, end, workspace.buckets);
+        }
+        return end;
+    }
+
+    /**
+     * @brief Steps 1-4 shared by both normal forms, on caller-owned buffers.
+     *
+     * X_vector / Y_vector are the X-vector at the start and the Y-vector at the end of w (all 1 if null).
+     * Leaves the normal form in workspace.buffer[workspace.begin, |w|) and the new X-/Y-vectors in
+     * workspace.xVector / yVector. If `result` is given, its stackMasks and arch_ends are filled as well.
+     * threads: threads of the X pass, see parallelXCoordinates
+     */
+    void shortlexKernel(string_view w,
+        const vector<int> *X_vector,
+        const vector<int> *Y_vector,
+        int threshold,
+        ShortlexWorkspace &workspace,
+        ShortlexResult *result,
+        int threads = 1) {
+        keepLetters(w, X_vector, Y_vector, threshold, workspace, threads);
+        normalXCoordinates(X_vector, threshold, workspace);
+
+        // 4. Lexicographically reorder blocks
+        // also, compute the stack form of SNF.
+        if (result != nullptr) {
+            result->stackMasks.clear();
+            result->arch_ends.clear();
+        }
+        int n = w.size();
+        int begin = workspace.begin;
+        int alphabet_size = workspace.alphabet.count();
+        SymbolMask alphabet_track;
+        int start = begin;
+        while (start < n) {
+            int end = sortBlock(workspace, start, threshold);
+
+            if (result != nullptr) {
+                // push block to stack form (top of the stack at the back)
+                SymbolMask block_mask;
+                for (int i = start; i < end; i++) {
+                    block_mask.set(Alphabet::getInstance().charToIndex(workspace.buffer[i]));
+                }
+                result->stackMasks.push_back(block_mask);
+
+                // detect arch ends
+                alphabet_track |= block_mask;
+                if (alphabet_track.count() == alphabet_size) {
+                    result->arch_ends.push_back(end - begin);
+                    alphabet_track = SymbolMask();
+                }
+            }
+
+            start = end;
+        }
+    }
+
+    SymbolMask alphabetOf(string_view w) {
+        SymbolMask alphabet;
+        for (char c : w) alphabet.set(Alphabet::getInstance().charToIndex(c));
+        return alphabet;
+    }
+
+    // Number of archs of w over `alphabet`
+    int universalityOf(string_view w, const SymbolMask &alphabet) {
+        int universality = 0;
+        SymbolMask seen;
+        for (char c : w) {
+            seen.set(Alphabet::getInstance().charToIndex(c));
+            if (seen == alphabet) {
+                universality++;
+                seen = SymbolMask();
+            }
+        }
+        return universality;
+    }
+
+    // -------------------- Batch kernel --------------------
+    // Counters of one symbol for LANES words at once; the min over all symbols is then one vector op per symbol
+
+    // Scratch space of shortlexLanes, reused across groups
+    struct LaneWorkspace {
+        vector<LaneVector> counters;  // [charIndex]
+        vector<LaneVector> seedX;     // [charIndex] X_vector saturated at threshold + 1
+        vector<LaneVector> seedY;
+        vector<uint8_t> X;           // [i * LANES + lane] X-coordinate of words[lane][i]
+        string kept[LANES];          // kept letters of each lane, right-to-left, then in order
+        vector<uint8_t> keptY[LANES];
+        vector<uint8_t> keptX[LANES];
+        array<int, 256> buckets = {};
+    };
+
+    // counters[c[lane]][lane] <- value[lane] for the lanes with value < 255, then every counter is clamped to value
+    inline void clampLanes(vector<LaneVector> &counters, const int *c, LaneVector value) {
+        for (int lane = 0; lane < LANES; lane++) {
+            if (value[lane] != UINT8_MAX) counters[c[lane]][lane] = value[lane];
+        }
+        for (LaneVector &counter : counters) counter = counter < value ? counter : value;
+    }
+
+    // X-coordinates of the letters of each lane, from the shared seeds
+    template <typename Letters>
+    void xLanes(LaneWorkspace &workspace, const int *length, int maxLength, int cap, Letters letter, uint8_t *X) {
+        workspace.counters = workspace.seedX;
+        int c[LANES] = {};
+        for (int i = 0; i < maxLength; i++) {
+            LaneVector value;
+            for (int lane = 0; lane < LANES; lane++) {
+                value[lane] = UINT8_MAX;
+                if (i >= length[lane]) continue;
+                c[lane] = Alphabet::getInstance().charToIndex(letter(lane, i));
+                X[i * LANES + lane] = workspace.counters[c[lane]][lane];
+                value[lane] = min<int>(X[i * LANES + lane] + 1, cap);
+            }
+            clampLanes(workspace.counters, c, value);
+        }
+    }
+
+    /**
+     * @brief Steps 1-4 for `count` <= LANES words of length <= SHORTLEX_BATCH_MAX_LENGTH, one word per lane.
+     *
+     * Counters saturate at cap = threshold + 1 <= 254: min and +1 commute with min(., cap), and a letter is
+     * kept iff X + Y <= threshold, so saturated coordinates give the same letters and blocks.
+     */
+    void shortlexLanes(const string *const *words,
+        int count,
+        int threshold,
+        LaneWorkspace &workspace,
+        string *const *out) {
+        int cap = threshold + 1;
+        int length[LANES] = {};
+        int maxLength = 0;
+        for (int lane = 0; lane < count; lane++) {
+            length[lane] = words[lane]->size();
+            maxLength = max(maxLength, length[lane]);
+        }
+        workspace.X.resize(maxLength * LANES);
+
+        // 1. Compute X-coordinates
+        xLanes(workspace, length, maxLength, cap, [&](int lane, int i) { return (*words[lane])[i]; },
+            workspace.X.data());
+
+        // 2. Compute Y-coordinates and keep the letters with X + Y <= threshold, right-to-left
+        workspace.counters = workspace.seedY;
+        int c[LANES] = {};
+        for (int lane = 0; lane < LANES; lane++) {
+            workspace.kept[lane].clear();
+            workspace.keptY[lane].clear();
+        }
+        for (int step = 0; step < maxLength; step++) {
+            LaneVector value;
+            for (int lane = 0; lane < LANES; lane++) {
+                value[lane] = UINT8_MAX;
+                int i = length[lane] - 1 - step;
+                if (i < 0) continue;
+                char letter = (*words[lane])[i];
+                c[lane] = Alphabet::getInstance().charToIndex(letter);
+                int y = workspace.counters[c[lane]][lane];
+                if (workspace.X[i * LANES + lane] + y <= threshold) {
+                    value[lane] = min(y + 1, cap);
+                    workspace.kept[lane] += letter;
+                    workspace.keptY[lane].push_back(y);
+                }
+            }
+            clampLanes(workspace.counters, c, value);
+        }
+
+        int keptLength[LANES] = {};
+        int maxKept = 0;
+        for (int lane = 0; lane < count; lane++) {
+            reverse(workspace.kept[lane].begin(), workspace.kept[lane].end());
+            reverse(workspace.keptY[lane].begin(), workspace.keptY[lane].end());
+            keptLength[lane] = workspace.kept[lane].size();
+            maxKept = max(maxKept, keptLength[lane]);
         }
 
-        start = end;
+        // 3. Re-compute X-coordinates based on the normal form (reusing X, laid out the same way)
+        xLanes(workspace, keptLength, maxKept, cap, [&](int lane, int i) { return workspace.kept[lane][i]; },
+            workspace.X.data());
+
+        // 4. Lexicographically reorder blocks of each lane
+        for (int lane = 0; lane < count; lane++) {
+            string &normal = workspace.kept[lane];
+            const vector<uint8_t> &Y = workspace.keptY[lane];
+            auto X = [&](int i) { return workspace.X[i * LANES + lane]; };
+            int n = normal.size();
+            int start = 0;
+            while (start < n) {
+                int end = start + 1;
+                while (end < n && X(end) == X(start) && Y[end] == Y[start] && X(start) + Y[start] == threshold) {
+                    end++;
+                }
+                if (end - start > 1) {
+                    countingSortBlock(normal, start, end, workspace.buckets);
+                }
+                start = end;
+            }
+            out[lane]->assign(normal);
+        }
     }
+}  // namespace
+
+void computeShortlexNormalForm(string_view w, int k, ShortlexWorkspace &workspace, string &out) {
+    shortlexKernel(w, nullptr, nullptr, k + 1, workspace, nullptr);
+    out.assign(workspace.buffer, workspace.begin, string::npos);
+}
+
+void computePartialShortlexNormalForm(string_view w,
+    const vector<int> &X_vector,
+    const vector<int> &Y_vector,
+    int threshold,
+    ShortlexWorkspace &workspace,
+    ShortlexResult &out,
+    int threads) {
+    shortlexKernel(w, &X_vector, &Y_vector, threshold, workspace, &out, threads);
+
+    out.shortlexNormalForm.assign(workspace.buffer, workspace.begin, string::npos);
+    out.fingerprint = Fingerprint::of(out.shortlexNormalForm);
+    out.X_vector.assign(workspace.xVector.begin(), workspace.xVector.end());
+    out.Y_vector.assign(workspace.yVector.begin(), workspace.yVector.end());
+    out.stackForm.clear();
+    out.alphabet.clear();
+    out.universality = out.arch_ends.size();
+}
+
+bool areSimonCongruent(string_view u,
+    string_view v,
+    int k,
+    ShortlexWorkspace &uWorkspace,
+    ShortlexWorkspace &vWorkspace) {
+    if (k <= 0) return true;
+
+    // Cheap invariants: u ~k v needs alph(u) = alph(v), and then either both are k-universal
+    // (every word of length <= k is a subsequence of both) or they have the same universality index
+    SymbolMask alphabet = alphabetOf(u);
+    if (alphabetOf(v) != alphabet) return false;
+    if (alphabet.count() == 0) return true;
+
+    int uUniversality = universalityOf(u, alphabet);
+    int vUniversality = universalityOf(v, alphabet);
+    if (uUniversality >= k && vUniversality >= k) return true;
+    if (uUniversality != vUniversality) return false;
+
+    // Normal forms of different lengths differ
+    keepLetters(u, nullptr, nullptr, k + 1, uWorkspace);
+    keepLetters(v, nullptr, nullptr, k + 1, vWorkspace);
+    int length = u.size() - uWorkspace.begin;
+    if (static_cast<int>(v.size()) - vWorkspace.begin != length) return false;
+
+    // Compare the normal forms block by block, stopping at the first difference
+    normalXCoordinates(nullptr, k + 1, uWorkspace);
+    normalXCoordinates(nullptr, k + 1, vWorkspace);
+    for (int offset = 0; offset < length;) {
+        int uStart = uWorkspace.begin + offset;
+        int vStart = vWorkspace.begin + offset;
+        int uEnd = sortBlock(uWorkspace, uStart, k + 1);
+        int vEnd = sortBlock(vWorkspace, vStart, k + 1);
+        if (uEnd - uStart != vEnd - vStart) return false;
+        if (uWorkspace.buffer.compare(uStart, uEnd - uStart, vWorkspace.buffer, vStart, vEnd - vStart) != 0) {
+            return false;
+        }
+        offset += uEnd - uStart;
+    }
+    return true;
+}
+
+bool areSimonCongruent(const string &u, const string &v, int k) {
+    ShortlexWorkspace uWorkspace, vWorkspace;
+    return areSimonCongruent(u, v, k, uWorkspace, vWorkspace);
+}
 
+/**
+   * @brief Computes the shortlex normal form of w (under Simon's congruence for parameter k)
+   *
+   * Testing Simon's congruence 논문 버전 SNF 계산 알고리즘
+  */
+string computeShortlexNormalForm(const string& w, int k) {
+    ShortlexWorkspace workspace;
+    string shortlexNormalForm;
+    computeShortlexNormalForm(w, k, workspace, shortlexNormalForm);
     return shortlexNormalForm;
 }
 
@@ -100,126 +554,68 @@ string computeShortlexNormalForm(const string& w, int k) {
    * @param X_vector   X-vector of T at start of w
    * @param Y_vector   Y-vector of T at end of w
    * @param threshold  if x + y > threshold, delete character.
-   * 
+   *
    * The value of threshold depends on whether w is a XY-link or YX-link.
    * XY-link: threshold = (k + 1 -(iota(p) - 1)) = k + 2 - iota(p)
    * YX-link: threshold = k + 1 - iota(p)
-   * 
+   *
    * Simon's congruence pattern matching 논문에서 필요한 SNF 계산 알고리즘
   */
 ShortlexResult
 computePartialShortlexNormalForm(const string& w, vector<int> X_vector, vector<int> Y_vector, int threshold) {
-    int n = w.size();
-    int ALPHABET_SIZE = Alphabet::getInstance().size();
-    set<char> w_alphabet;  // for detecting archs
-
-    vector<int> X(n, 0);  // X-coordinates
-    vector<int> Y(n, 0);  // Y-coordinates
-
-    string shortlexNormalForm;
-    deque<int> shortlexNormalX;  // X-coordinates of normal form
-    deque<int> shortlexNormalY;  // Y-coordinates of normal form
-
-    vector<int> new_X_vector = X_vector;  // X-vector which will be updated by iterating normal form
-    vector<int> new_Y_vector = Y_vector;  // Y-vector which will be updated by iterating normal form
-
-    // 1. Compute X-coordinates
-    for (int i = 0; i < n; i++) {
-        char c = w[i];
-        int alphabet_index = Alphabet::getInstance().charToIndex(c);
-
-        X[i] = X_vector[alphabet_index];
-        X_vector[alphabet_index]++;
-
-        for (int j = 0; j < ALPHABET_SIZE; j++) {
-            X_vector[j] = min(X_vector[j], X_vector[alphabet_index]);
-        }
+    ShortlexWorkspace workspace;
+    ShortlexResult result;
+    computePartialShortlexNormalForm(w, X_vector, Y_vector, threshold, workspace, result);
 
-        // for detecting archs, compute alph(w)
-        w_alphabet.insert(c);
+    // set-based stack form and alph(w), derived from the masks
+    for (const SymbolMask& block_mask : result.stackMasks) {
+        set<char> block_charset;
+        block_mask.forEach([&](int c) { block_charset.insert(Alphabet::getInstance().indexToChar(c)); });
+        result.stackForm.push_front(block_charset);
     }
+    workspace.alphabet.forEach([&](int c) { result.alphabet.insert(Alphabet::getInstance().indexToChar(c)); });
 
-    // 2. Compute Y-coordinates and normal form
-    for (int i = n - 1; i >= 0; i--) {
-        char c = w[i];
-        int alphabet_index = Alphabet::getInstance().charToIndex(c);
-
-        Y[i] = Y_vector[alphabet_index];
+    return result;
+}
 
-        if (X[i] + Y[i] <= threshold) {
-            Y_vector[alphabet_index]++;
+vector<string> computePartialShortlexNormalForms(const vector<string> &words,
+    const vector<int> &X_vector,
+    const vector<int> &Y_vector,
+    int threshold) {
+    vector<string> normalForms(words.size());
 
-            for (int j = 0; j < ALPHABET_SIZE; j++) {
-                Y_vector[j] = min(Y_vector[j], Y_vector[alphabet_index]);
-            }
-
-            shortlexNormalForm.insert(shortlexNormalForm.begin(), c);
-            shortlexNormalY.push_front(Y[i]);
+    // words for the lanes, by length so that the words of a group take about as many steps
+    vector<int> order;
+    ShortlexWorkspace workspace;
+    ShortlexResult result;
+    for (int i = 0; i < static_cast<int>(words.size()); i++) {
+        bool fitsLanes = threshold >= 0 && threshold + 1 < UINT8_MAX;
+        if (fitsLanes && static_cast<int>(words[i].size()) <= SHORTLEX_BATCH_MAX_LENGTH) {
+            order.push_back(i);
+        } else {
+            computePartialShortlexNormalForm(words[i], X_vector, Y_vector, threshold, workspace, result);
+            normalForms[i] = result.shortlexNormalForm;
         }
     }
-
-    // 3. Compute new X-vector based on normal form (and also recompute SNF's X-coordinates)
-    int m = shortlexNormalForm.size();
-    for (int i = 0; i < m; i++) {
-        char c = shortlexNormalForm[i];
-        int alphabet_index = Alphabet::getInstance().charToIndex(c);
-
-        shortlexNormalX.push_back(new_X_vector[alphabet_index]);
-        new_X_vector[alphabet_index]++;
-
-        for (int j = 0; j < ALPHABET_SIZE; j++) {
-            new_X_vector[j] = min(new_X_vector[j], new_X_vector[alphabet_index]);
-        }
+    if (order.empty()) return normalForms;
+    sort(order.begin(), order.end(), [&](int a, int b) { return words[a].size() < words[b].size(); });
+
+    LaneWorkspace lanes;
+    int cap = threshold + 1;
+    for (int c = 0; c < static_cast<int>(X_vector.size()); c++) {
+        lanes.seedX.push_back(LaneVector{} + static_cast<uint8_t>(min(X_vector[c], cap)));
+        lanes.seedY.push_back(LaneVector{} + static_cast<uint8_t>(min(Y_vector[c], cap)));
     }
-    // Y-vector is already updated based on normal form, so don't re-compute.
-    new_Y_vector = Y_vector;
-
-    // 4. Lexicographically reorder blocks
-    // block = elements whose coordinate (X,Y) are the same
-    // also, compute the stack form of SNF.
-    int start = 0;
-    deque<set<char>> stackForm;
-    set<char> alphabet_track;
-    vector<int> arch_ends;
-    while (start < m) {
-        // sort block
-        int end = start + 1;
-        while (end < m && shortlexNormalX[end] == shortlexNormalX[start] &&
-            shortlexNormalY[end] == shortlexNormalY[start] &&
-            (shortlexNormalX[start] + shortlexNormalY[start] == threshold)) {
-            end++;
-        }
-        if (end - start > 1) {
-            // TODO: replace to custom sorting algorithm --- ex) counting sort
-            sort(shortlexNormalForm.begin() + start, shortlexNormalForm.begin() + end);
-        }
-
-        // push block to stack form
-        // Note that we iterate from the beginning of normal form, so we push to bottom of stack form
-        set<char> block_charset;
-        for (int i = start; i < end; i++) {
-            char c = shortlexNormalForm[i];
-            block_charset.insert(c);
-            alphabet_track.insert(c);
-        }
-        stackForm.push_front(block_charset);
 
-        // detect arch ends
-        if (alphabet_track.size() == w_alphabet.size()) {
-            arch_ends.push_back(end);
-            alphabet_track.clear();
+    for (int first = 0; first < static_cast<int>(order.size()); first += LANES) {
+        int count = min<int>(LANES, order.size() - first);
+        const string *group[LANES];
+        string *out[LANES];
+        for (int lane = 0; lane < count; lane++) {
+            group[lane] = &words[order[first + lane]];
+            out[lane] = &normalForms[order[first + lane]];
         }
-
-        start = end;
+        shortlexLanes(group, count, threshold, lanes, out);
     }
-
-    ShortlexResult result;
-    result.shortlexNormalForm = shortlexNormalForm;
-    result.X_vector = new_X_vector;
-    result.Y_vector = new_Y_vector;
-    result.stackForm = stackForm;
-    result.arch_ends = arch_ends;
-    result.alphabet = w_alphabet;
-    result.universality = arch_ends.size();
-    return result;
+    return normalForms;
 }
@@ -1,17 +1,23 @@
 #include "data/SimonTree.h"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <memory>
-#include <unordered_map>
 #include <vector>
 
+#include "utils/Alphabet.h"
+#include "utils/Common.h"
+#include "utils/CountingSort.h"
+#include "utils/Parallel.h"
+
 using namespace std;
 using namespace SimonTree;
 
 Node::Node(int start, int end, int depth) : start(start), end(end), depth(depth) {}
 
 Node::Node(int start, int end, int depth, std::shared_ptr<Node> parent)
-    : start(start), end(end), depth(depth), parent(parent) {}
+    : start(start), end(end), depth(depth), parent(parent.get()) {}
 
 bool Node::isRoot() const { return parent == nullptr; }
 
@@ -21,14 +27,13 @@ bool Node::isLeaf() const { return children.empty(); }
 vector<int> SimonTree::computeX(const string &w) {
     int n = w.size();
     vector<int> X(n + 2, n + 1);  // 1-based, X[n+1] = ∞
-    unordered_map<char, int> lastSeen;
+    array<int, 256> lastSeen;
+    lastSeen.fill(n + 1);
 
     for (int i = n; i >= 1; --i) {
-        char c = w[i - 1];
-        if (lastSeen.count(c)) {
-            X[i] = lastSeen[c];
-        }
-        lastSeen[c] = i;
+        int &next = lastSeen[static_cast<unsigned char>(w[i - 1])];
+        X[i] = next;
+        next = i;
     }
 
     return X;
@@ -43,7 +48,7 @@ shared_ptr<Node> SimonTree::findNode(int i, const vector<int> &X, shared_ptr<Nod
             return a;
         } else {
             a->start = i + 1;  // Close block
-            a = a->parent;
+            a = a->parent->shared_from_this();
         }
     }
     return a;
@@ -100,3 +105,469 @@ void SimonTree::printTree(const shared_ptr<Node> &node, const string &w, string
         printTree(node->children[i], w, indent, i == node->children.size() - 1);
     }
 }
+
+// -------------------- Flat tree --------------------
+Tree SimonTree::buildTree(const string &w) {
+    TreeBuilder builder;
+    builder.pushFront(w);
+    return builder.finish();
+}
+
+// -------------------- Streaming builder --------------------
+// Positions are shifted by -|w| so that they do not depend on the letters still to come: the letter being added
+// is at -letters, and "no next occurrence" (|w| + 1) as well as the end of the open root are at 1.
+TreeBuilder::TreeBuilder() : TreeBuilder(nullptr) {}
+
+TreeBuilder::TreeBuilder(Sink sink) : sink(move(sink)) {
+    nextSeen.fill(1);
+    openNode(1, NO_NODE);
+}
+
+int64_t TreeBuilder::openNode(int64_t end, int64_t nextSibling) {
+    if (!sink) {
+        for (vector<int32_t> *column :
+            {&tree.start, &tree.end, &tree.depth, &tree.parent, &tree.firstChild, &tree.nextSibling}) {
+            column->push_back(NO_NODE);
+        }
+    }
+    path.push_back({nodes, end, NO_NODE, nextSibling});
+    return nodes++;
+}
+
+void TreeBuilder::close(const OpenNode &open, int64_t start, int depth) {
+    ClosedNode closed = {open.node, start, open.end, depth, depth == 0 ? NO_NODE : path[depth - 1].node,
+        open.firstChild, open.nextSibling};
+    if (sink) {
+        sink(closed);
+        return;
+    }
+    tree.start[closed.node] = closed.start;
+    tree.end[closed.node] = closed.end;
+    tree.depth[closed.node] = closed.depth;
+    tree.parent[closed.node] = closed.parent;
+    tree.firstChild[closed.node] = closed.firstChild;
+    tree.nextSibling[closed.node] = closed.nextSibling;
+}
+
+void TreeBuilder::pushFront(string_view chunk) {
+    if (!sink) {
+        for (vector<int32_t> *column :
+            {&tree.start, &tree.end, &tree.depth, &tree.parent, &tree.firstChild, &tree.nextSibling}) {
+            column->reserve(nodes + 2 * chunk.size());  // at most two nodes per letter
+        }
+    }
+
+    for (int j = chunk.size() - 1; j >= 0; j--) {
+        int64_t i = -letters;
+        int64_t &next = nextSeen[static_cast<unsigned char>(chunk[j])];  // X[i]
+
+        // findNode: close the open nodes below the one the new leaf hangs from
+        while (path.size() > 1 && !(next >= path.back().end && next < path[path.size() - 2].end)) {
+            close(path.back(), i + 1, path.size() - 1);
+            path.pop_back();
+        }
+        next = i;
+
+        // splitNode
+        if (path.back().firstChild == NO_NODE && path.size() > 1) {
+            // complete the current leaf
+            int depth = path.size();
+            int64_t completed = openNode(i + 1, NO_NODE);
+            close(path.back(), i + 1, depth);
+            path.pop_back();
+            path.back().firstChild = completed;
+        }
+        int64_t newLeaf = openNode(i, path.back().firstChild);
+        path[path.size() - 2].firstChild = newLeaf;
+        letters++;
+    }
+}
+
+Tree TreeBuilder::finish() {
+    // fixTree: the open path starts at 1, the root ends at |w| (the other last children already do)
+    path.front().end = 0;
+    while (!path.empty()) {
+        close(path.back(), 1 - letters, path.size() - 1);
+        path.pop_back();
+    }
+    for (int32_t &start : tree.start) start += letters;
+    for (int32_t &end : tree.end) end += letters;
+    return move(tree);
+}
+
+namespace {
+    // Preorder walk calling enter(node) before and leave(node) after the subtree of node, in O(1) extra space
+    template <typename Enter, typename Leave>
+    void walkTree(const Tree &tree, Enter enter, Leave leave) {
+        int32_t node = ROOT;
+        while (true) {
+            enter(node);
+            if (!tree.isLeaf(node)) {
+                node = tree.firstChild[node];
+                continue;
+            }
+            while (true) {
+                leave(node);
+                if (node == ROOT) return;
+                if (tree.nextSibling[node] != NO_NODE) {
+                    node = tree.nextSibling[node];
+                    break;
+                }
+                node = tree.parent[node];
+            }
+        }
+    }
+}  // namespace
+
+void SimonTree::printTree(const Tree &tree, const string &w, ostream &out) {
+    string indent;
+    vector<size_t> indentLength;  // [depth] length of indent before the node at that depth was entered
+    walkTree(
+        tree,
+        [&](int32_t node) {
+            indentLength.push_back(indent.size());
+            int start = tree.start[node], end = tree.end[node];
+            if (start == -1 || start > (int)w.size()) return;
+
+            bool isLast = tree.nextSibling[node] == NO_NODE;
+            out << indent;
+            if (tree.depth[node] > 0) out << (isLast ? "└── " : "├── ");
+            out << string_view(w).substr(start - 1, end - start + 1);
+            if (start == end) {
+                out << "[" << start << "]\n";
+            } else {
+                out << "[" << start << ":" << end << "] (k=" << tree.depth[node] << ")\n";
+            }
+            indent += (isLast ? "    " : "│   ");
+        },
+        [&](int32_t) {
+            indent.resize(indentLength.back());
+            indentLength.pop_back();
+        });
+}
+
+void SimonTree::writeTreeJson(const Tree &tree, ostream &out) {
+    walkTree(
+        tree,
+        [&](int32_t node) {
+            if (node != ROOT && tree.firstChild[tree.parent[node]] != node) out << ",";
+            out << "{\"start\":" << tree.start[node] << ",\"end\":" << tree.end[node]
+                << ",\"depth\":" << tree.depth[node] << ",\"children\":[";
+        },
+        [&](int32_t) { out << "]}"; });
+    out << "\n";
+}
+
+// -------------------- Shortlex normal form --------------------
+// Building the Simon tree of w from the right (as above), the leaf opened for position i sits at depth Y(i), the
+// Y-coordinate of w[i]; from the left, at depth X(i). Only the open nodes matter for that, and they form a path
+// whose blocks end (from the right) or start (from the left) monotonically with depth, so the path is kept as the
+// array of those positions, indexed by depth (the root at depth 0).
+string SimonTree::computeShortlexNormalForm(const string &w, int k) {
+    int n = w.size();
+    int threshold = k + 1;
+    array<int, 256> lastSeen;
+
+    // X-coordinates of word[0, length) into X, Simon tree built from the left: path[d] is the start of the open
+    // node at depth d, increasing with d. The new leaf hangs below the shallowest open node starting at or after
+    // the previous occurrence of its letter; the deeper ones get closed.
+    vector<int> path;
+    auto xCoordinates = [&](const string &word, int length, vector<int> &X) {
+        lastSeen.fill(-1);
+        path.assign(1, -1);
+        for (int i = 0; i < length; i++) {
+            int &previous = lastSeen[static_cast<unsigned char>(word[i])];
+            while (path.size() > 1 && path[path.size() - 2] >= previous) path.pop_back();
+            X[i] = path.size();
+            path.push_back(i);
+            previous = i;
+        }
+    };
+
+    // 1. Compute X-coordinates
+    vector<int> X(n);
+    xCoordinates(w, n, X);
+
+    // 2. Compute Y-coordinates and normal form: Simon tree of the kept letters, built from the right. path[d] is the
+    // end of the open node at depth d, decreasing with d, and a deleted letter must leave the tree untouched, so
+    // the depth of its leaf is found by binary search instead of by closing nodes.
+    string kept;
+    vector<int> keptY;
+    lastSeen.fill(n);
+    path.assign(1, n);
+    for (int i = n - 1; i >= 0; i--) {
+        int &next = lastSeen[static_cast<unsigned char>(w[i])];
+        int parent = partition_point(path.begin(), path.end(), [&](int end) { return end > next; }) - path.begin();
+        int y = parent + 1;
+
+        // If X[i] + Y[i] is at most the threshold, then we keep the letter.
+        if (X[i] + y <= threshold) {
+            path.resize(parent + 1);
+            path.push_back(i);
+            next = i;
+            kept += w[i];
+            keptY.push_back(y);
+        }
+    }
+    reverse(kept.begin(), kept.end());
+    reverse(keptY.begin(), keptY.end());
+
+    // 3. Re-compute X-coordinates based on the normal form
+    int m = kept.size();
+    vector<int> keptX(m);
+    xCoordinates(kept, m, keptX);
+
+    // 4. Lexicographically reorder blocks, by counting sort
+    // block = elements whose coordinate (X,Y) are the same
+    array<int, 256> buckets = {};
+    int start = 0;
+    while (start < m) {
+        int end = start + 1;
+        while (end < m && keptX[end] == keptX[start] && keptY[end] == keptY[start] &&
+            keptX[start] + keptY[start] == threshold) {
+            end++;
+        }
+        if (end - start > 1) countingSortBlock(kept, start, end, buckets);
+        start = end;
+    }
+
+    return kept;
+}
+
+// -------------------- Congruence levels --------------------
+CongruenceTree::CongruenceTree(const string &w) : word(w), tree(buildTree(w)), next(w) {
+    next.buildXRankerTable(1);
+    int n = w.size();
+    int sigma = Alphabet::getInstance().size();
+
+    childBegin.reserve(tree.nodeCount() + 1);
+    children.reserve(tree.nodeCount());
+    adjacentLevel.assign(n + 1, 0);  // adjacentLevel[n] = 0: a nonempty suffix against the empty one
+    for (int32_t node = 0; node < tree.nodeCount(); node++) {
+        childBegin.push_back(children.size());
+        for (int32_t child = tree.firstChild[node]; child != NO_NODE; child = tree.nextSibling[child]) {
+            // leaves p and p + 1 split below node exactly when a child of node starts at p + 1
+            if (child != tree.firstChild[node]) adjacentLevel[tree.start[child] - 1] = tree.depth[node];
+            children.push_back(child);
+        }
+    }
+    childBegin.push_back(children.size());
+
+    byAlphabetSize.assign(sigma + 1, NO_NODE);
+    for (int i = childBegin[ROOT]; i < childBegin[ROOT + 1] && n > 0; i++) {
+        int size = 0;
+        for (int c = 0; c < sigma; c++) size += next.getXByIndex(tree.start[children[i]] - 1, c) != INF;
+        byAlphabetSize[size] = children[i];
+    }
+
+    int blocks = n / BLOCK + 1;
+    blockMin.emplace_back(blocks, INF);
+    for (int p = 0; p <= n; p++) blockMin[0][p / BLOCK] = min(blockMin[0][p / BLOCK], adjacentLevel[p]);
+    for (int span = 1; 2 * span <= blocks; span *= 2) {
+        const vector<int32_t> &previous = blockMin.back();
+        vector<int32_t> level(blocks - 2 * span + 1);
+        for (size_t b = 0; b < level.size(); b++) level[b] = min(previous[b], previous[b + span]);
+        blockMin.push_back(move(level));
+    }
+}
+
+int CongruenceTree::level(int p, int q) const {
+    if (p == q) return INF;
+    int from = min(p, q), to = max(p, q);  // minimum over adjacentLevel[from, to)
+    int firstBlock = from / BLOCK, lastBlock = (to - 1) / BLOCK;
+    int result = INF;
+    if (lastBlock - firstBlock <= 1) {
+        for (int i = from; i < to; i++) result = min(result, adjacentLevel[i]);
+        return result;
+    }
+    for (int i = from; i < (firstBlock + 1) * BLOCK; i++) result = min(result, adjacentLevel[i]);
+    for (int i = lastBlock * BLOCK; i < to; i++) result = min(result, adjacentLevel[i]);
+    int blocks = lastBlock - firstBlock - 1;
+    int row = 31 - __builtin_clz(blocks);
+    result = min(result, blockMin[row][firstBlock + 1]);
+    return min(result, blockMin[row][lastBlock - (1 << row)]);
+}
+
+namespace {
+    enum class Test { Match, Left, Right, None };
+
+    /**
+     * Matches the blocks of T_u against those of T_v, level by level from the root down.
+     *
+     * With t_a the position after the first a in a suffix, u[e:] ~k v[j:] iff both have the same letters and
+     * u[t_a:] ~(k-1) v[t'_a:] for each of them. Blocks of T_u are visited by decreasing end, parents first, so the
+     * suffixes after the first letters of a block are settled before the block: for each position t of u, its
+     * deepest match is known as (matchLevel[t], matchAt[t]), the largest level of a block of u containing t that has
+     * a match, and a position of that match. Then u[t:] ~k v[s:] iff k <= matchLevel[t] and v[s:] ~k v[matchAt[t]:].
+     */
+    class LevelMatcher {
+    public:
+        LevelMatcher(const CongruenceTree &u, const CongruenceTree &v)
+            : u(u), v(v), sigma(Alphabet::getInstance().size()) {}
+
+        int run() {
+            int n = u.length(), m = v.length();
+            if (u.word == v.word) return INF;
+            if (n == 0 || m == 0) return 0;
+
+            matchLevel.assign(n + 2, 0);
+            matchAt.assign(n + 2, 1);
+            matchLevel[n + 1] = INF;  // the empty suffix matches the empty suffix only
+            matchAt[n + 1] = m + 1;
+            match.assign(u.tree.nodeCount(), NO_NODE);
+            cursor.assign(u.tree.nodeCount(), 0);
+            match[ROOT] = ROOT;
+
+            // preorder, last child first: blocks by decreasing end, parents before children
+            vector<int32_t> pending;
+            pushChildren(ROOT, pending);
+            while (!pending.empty()) {
+                int32_t node = pending.back();
+                pending.pop_back();
+                int32_t parent = u.tree.parent[node];
+                int depth = u.tree.depth[node];
+                int end = u.tree.end[node];
+
+                int32_t found = depth == 1 ? matchAlphabet(end) : matchChild(end, depth, match[parent], cursor[parent]);
+                if (found == NO_NODE) {
+                    for (int t = u.tree.start[node]; t <= end; t++) {
+                        matchLevel[t] = depth - 1;
+                        matchAt[t] = v.tree.start[match[parent]];
+                    }
+                    continue;
+                }
+                match[node] = found;
+                if (u.tree.isLeaf(node)) {
+                    matchLeaf(end, depth, found);
+                    continue;
+                }
+                cursor[node] = v.childBegin[found + 1] - 1;
+                pushChildren(node, pending);
+            }
+            return min(matchLevel[1], v.level(matchAt[1], 1));
+        }
+
+    private:
+        const CongruenceTree &u;
+        const CongruenceTree &v;
+        int sigma;
+        vector<int> matchLevel;  // [t] for 1 <= t <= |u| + 1, see above
+        vector<int> matchAt;     // [t]
+        vector<int32_t> match;   // [node of T_u] node of T_v holding the suffixes ~depth to it, NO_NODE if none
+        vector<int32_t> cursor;  // [node of T_u] next child of match[node] its children are tested against
+
+        void pushChildren(int32_t node, vector<int32_t> &pending) const {
+            for (int32_t child = u.tree.firstChild[node]; child != NO_NODE; child = u.tree.nextSibling[child]) {
+                pending.push_back(child);
+            }
+        }
+
+        // Block of T_v at depth 1 with the same letters as u[e:]
+        int32_t matchAlphabet(int e) const {
+            int size = 0;
+            for (int c = 0; c < sigma; c++) size += u.next.getXByIndex(e - 1, c) != INF;
+            int32_t found = v.byAlphabetSize[size];
+            if (found == NO_NODE) return NO_NODE;
+            int j = v.tree.start[found];
+            for (int c = 0; c < sigma; c++) {
+                if ((u.next.getXByIndex(e - 1, c) != INF) != (v.next.getXByIndex(j - 1, c) != INF)) return NO_NODE;
+            }
+            return found;
+        }
+
+        /**
+         * u[e:] ~k v[j:] for k >= 2, given u[e:] ~(k-1) v[j:]. Otherwise Left if every v[j':] ~k u[e:] has j' < j
+         * (checked first, as the letter concerned rules out j for the blocks of u left of e as well), Right if
+         * j' > j, and None if u[e:] has no match at level k.
+         */
+        Test test(int e, int k, int j) const {
+            bool left = false, right = false;
+            for (int c = 0; c < sigma; c++) {
+                int uNext = u.next.getXByIndex(e - 1, c);
+                if (uNext == INF) continue;
+                int vNext = v.next.getXByIndex(j - 1, c);
+                if (vNext == INF) return Test::None;
+
+                int t = uNext + 1, s = vNext + 1;
+                if (matchLevel[t] < k - 1) return Test::None;
+                if (v.level(matchAt[t], s) >= k - 1) continue;
+                // v[s':] ~(k-1) u[t:] only for s' on the side of matchAt[t], and s' grows with j
+                (matchAt[t] < s ? left : right) = true;
+            }
+            if (left) return Test::Left;
+            return right ? Test::Right : Test::Match;
+        }
+
+        /**
+         * Match at depth k of the block ending at e, among the children of `parentMatch`, the match of its parent.
+         * Siblings come last first, and their matches are in the same order, so `next` walks the children of
+         * parentMatch leftwards once for all of them.
+         */
+        int32_t matchChild(int e, int k, int32_t parentMatch, int32_t &next) const {
+            if (v.tree.isLeaf(parentMatch)) {
+                return test(e, k, v.tree.start[parentMatch]) == Test::Match ? parentMatch : NO_NODE;
+            }
+            for (; next >= v.childBegin[parentMatch]; next--) {
+                int32_t child = v.children[next];
+                Test result = test(e, k, v.tree.start[child]);
+                if (result == Test::Match) return v.children[next--];
+                if (result != Test::Left) break;
+            }
+            return NO_NODE;
+        }
+
+        // Deepest match of the leaf of position t of T_u, matched to `found` at its depth k
+        void matchLeaf(int t, int k, int32_t found) {
+            while (!v.tree.isLeaf(found)) {
+                int32_t next = v.childBegin[found + 1] - 1;
+                int32_t child = matchChild(t, k + 1, found, next);
+                if (child == NO_NODE) break;
+                found = child;
+                k++;
+            }
+            matchAt[t] = v.tree.start[found];
+            matchLevel[t] = v.tree.isLeaf(found) ? leafLevel(t, matchAt[t]) : k;
+        }
+
+        // Largest k with u[t:] ~k v[s:], for suffixes with the same letters: 1 + the minimum over their letters
+        int leafLevel(int t, int s) const {
+            int result = INF;
+            for (int c = 0; c < sigma; c++) {
+                int uNext = u.next.getXByIndex(t - 1, c);
+                if (uNext == INF) continue;
+                int after = uNext + 1;
+                int vAfter = v.next.getXByIndex(s - 1, c) + 1;
+                result = min({result, matchLevel[after], v.level(matchAt[after], vAfter)});
+            }
+            return result == INF ? INF : result + 1;
+        }
+    };
+}  // namespace
+
+int SimonTree::maxCongruenceLevel(const CongruenceTree &u, const CongruenceTree &v) {
+    return LevelMatcher(u, v).run();
+}
+
+int SimonTree::maxCongruenceLevel(const string &u, const string &v) {
+    return maxCongruenceLevel(CongruenceTree(u), CongruenceTree(v));
+}
+
+vector<vector<int>> SimonTree::maxCongruenceLevels(const vector<string> &words, int threads) {
+    int m = words.size();
+    vector<unique_ptr<CongruenceTree>> trees(m);
+    parallelFor(0, m, threads, [&](int i) { trees[i] = make_unique<CongruenceTree>(words[i]); });
+
+    // row i and row m - 1 - i together hold m - 1 pairs (i, j) with i < j: split those row pairs over the threads
+    vector<vector<int>> levels(m, vector<int>(m, INF));
+    parallelChunks(0, (m + 1) / 2, threads, [&](int chunkBegin, int chunkEnd, int) {
+        for (int t = chunkBegin; t < chunkEnd; t++) {
+            for (int i : {t, m - 1 - t}) {
+                for (int j = i + 1; j < m; j++) {
+                    levels[i][j] = levels[j][i] = maxCongruenceLevel(*trees[i], *trees[j]);
+                }
+                if (i == m - 1 - i) break;  // middle row of an odd m
+            }
+        }
+    });
+    return levels;
+}
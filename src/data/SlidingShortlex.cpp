@@ -0,0 +1,55 @@
+#include "data/SlidingShortlex.h"
+
+#include <stdexcept>
+
+#include "utils/Alphabet.h"
+
+using namespace std;
+
+SlidingShortlex::SlidingShortlex(int k) : k(k) {}
+
+void SlidingShortlex::combine(string_view u, string_view v, string &out) {
+    scratch.assign(u);
+    scratch += v;
+    computeShortlexNormalForm(scratch, k, workspace, out);
+}
+
+void SlidingShortlex::pushBack(char c) {
+    Alphabet::getInstance().charToIndex(c);  // throws std::out_of_range before the window changes
+    back += c;
+    combine(backNormal, string_view(&c, 1), backNormal);
+    currentValid = false;
+}
+
+void SlidingShortlex::popFront() {
+    if (empty()) throw out_of_range("SlidingShortlex: pop from an empty window");
+
+    // transfer the back stack, newest letter first, folding the normal forms of the suffixes of the front part
+    if (front.empty()) {
+        for (int i = back.size() - 1; i >= 0; i--) {
+            front.push_back(back[i]);
+            frontNormal.emplace_back();
+            string_view rest = frontNormal.size() >= 2 ? string_view(frontNormal[frontNormal.size() - 2]) : "";
+            combine(string_view(&back[i], 1), rest, frontNormal.back());
+        }
+        back.clear();
+        backNormal.clear();
+    }
+
+    front.pop_back();
+    frontNormal.pop_back();
+    currentValid = false;
+}
+
+const string &SlidingShortlex::normalForm() {
+    if (!currentValid) {
+        combine(frontNormal.empty() ? "" : string_view(frontNormal.back()), backNormal, current);
+        currentValid = true;
+    }
+    return current;
+}
+
+ShortlexResult SlidingShortlex::shortlex() {
+    vector<int> ones(Alphabet::getInstance().size(), 1);
+    return computePartialShortlexNormalForm(normalForm(), ones, ones, k + 1);
+}
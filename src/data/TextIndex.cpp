@@ -0,0 +1,295 @@
+#include "data/TextIndex.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "data/XYTree.h"
+#include "utils/Alphabet.h"
+#include "utils/SymbolMask.h"
+
+using namespace std;
+
+// -------------------- File layout --------------------
+// [Header][TextIndexSegment x segmentCount][encoded text][per segment: X cells, Y cells, X parents, Y parents]
+// Every section starts 8-byte aligned. Offsets are absolute file offsets.
+namespace {
+    constexpr char MAGIC[8] = {'T', 'C', 'M', 'I', 'N', 'D', 'E', 'X'};
+    constexpr uint8_t NOT_IN_ALPHABET = 0xFF;  // encoded text value of chars outside the alphabet
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t alphabetSize;
+        char alphabet[256];
+        uint64_t textLength;
+        uint64_t segmentCount;
+        uint64_t segmentsOffset;
+        uint64_t textOffset;
+    };
+
+    uint64_t align8(uint64_t offset) { return (offset + 7) & ~uint64_t(7); }
+
+    void padTo(ofstream& out, uint64_t offset) {
+        static const char zeros[8] = {};
+        uint64_t position = out.tellp();
+        out.write(zeros, offset - position);
+    }
+
+    template <typename T>
+    void writeArray(ofstream& out, const vector<T>& values) {
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    // Writes `count` cells obtained from copy(from, count, buffer) through a fixed-size buffer, so that the
+    // builder never holds a second copy of a ranker table
+    template <typename Copy>
+    void writeCells(ofstream& out, size_t count, Copy copy) {
+        constexpr size_t BLOCK = 1 << 16;
+        vector<uint32_t> buffer(min(count, BLOCK));
+        for (size_t from = 0; from < count; from += BLOCK) {
+            size_t cells = min(count - from, BLOCK);
+            copy(from, cells, buffer.data());
+            out.write(reinterpret_cast<const char*>(buffer.data()), cells * sizeof(uint32_t));
+        }
+    }
+
+    // true if `count` elements of `elementSize` bytes starting at `offset` lie inside a file of `size` bytes,
+    // at an 8-byte aligned offset (checked without overflowing)
+    bool fits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t size) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+    }
+}  // namespace
+
+struct TextIndexSegment {
+    int32_t start;
+    int32_t end;
+    uint64_t xCellsOffset;  // uint32_t[(len + 1) * sigma], RankerTable encoding
+    uint64_t yCellsOffset;  // uint32_t[(len + 1) * sigma], RankerTable encoding
+    uint64_t xParentsOffset;  // int32_t[len + 1]
+    uint64_t yParentsOffset;  // int32_t[len + 1]
+};
+
+/**
+ * @brief Builds the index of `text` over `alphabet` and writes it to `path`.
+ *
+ * Segments are the maximal runs of chars inside the alphabet (line 5 of MatchSimK).
+ * X-cells hold the X-rank (INF as UINT32_MAX), Y-cells hold the Y-rank + 1, as in RankerTable: they are copied
+ * from its flat buffers, and the ranker table is released before the tree parents are computed.
+ */
+void TextIndex::build(const string& text, const string& alphabet, const string& path) {
+    set<char> alphabetSet(alphabet.begin(), alphabet.end());
+    string sortedAlphabet(alphabetSet.begin(), alphabetSet.end());
+    if (sortedAlphabet.empty() || sortedAlphabet.size() >= NOT_IN_ALPHABET) {
+        throw runtime_error("TextIndex: alphabet must have between 1 and 254 chars");
+    }
+    if (text.size() >= static_cast<size_t>(numeric_limits<int32_t>::max())) {
+        throw runtime_error("TextIndex: text is too long");
+    }
+    Alphabet::getInstance().setAlphabet(sortedAlphabet);
+    int sigma = sortedAlphabet.size();
+
+    // Slice text whenever text[i] is not in the alphabet
+    vector<Interval> segments;
+    int start = 0;
+    int end = 0;
+    for (char t : text) {
+        if (alphabetSet.count(t) == 0) {
+            if (start < end) segments.emplace_back(start, end);
+            end++;
+            start = end;
+            continue;
+        }
+        end++;
+    }
+    if (start < end) {
+        segments.emplace_back(start, end);
+    }
+
+    // Lay out the file
+    Header header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.alphabetSize = sigma;
+    memcpy(header.alphabet, sortedAlphabet.data(), sigma);
+    header.textLength = text.size();
+    header.segmentCount = segments.size();
+
+    uint64_t offset = sizeof(Header);
+    header.segmentsOffset = offset;
+    offset = align8(offset + segments.size() * sizeof(TextIndexSegment));
+    header.textOffset = offset;
+    offset = align8(offset + text.size());
+
+    vector<TextIndexSegment> records;
+    for (Interval segment : segments) {
+        uint64_t length = segment.end - segment.start;
+        uint64_t cells = (length + 1) * sigma;
+
+        TextIndexSegment record;
+        record.start = segment.start;
+        record.end = segment.end;
+        record.xCellsOffset = offset;
+        offset = align8(offset + cells * sizeof(uint32_t));
+        record.yCellsOffset = offset;
+        offset = align8(offset + cells * sizeof(uint32_t));
+        record.xParentsOffset = offset;
+        offset = align8(offset + (length + 1) * sizeof(int32_t));
+        record.yParentsOffset = offset;
+        offset = align8(offset + (length + 1) * sizeof(int32_t));
+        records.push_back(record);
+    }
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) throw runtime_error("TextIndex: cannot open " + path + " for writing");
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    writeArray(out, records);
+
+    padTo(out, header.textOffset);
+    vector<uint8_t> encoded(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        encoded[i] = alphabetSet.count(text[i]) ? Alphabet::getInstance().charToIndex(text[i]) : NOT_IN_ALPHABET;
+    }
+    writeArray(out, encoded);
+
+    SymbolMask symbols = SymbolMask::fromChars(sortedAlphabet);
+    for (size_t s = 0; s < segments.size(); s++) {
+        string segmentText = text.substr(segments[s].start, segments[s].end - segments[s].start);
+        size_t cells = (segmentText.size() + 1) * sigma;
+        {
+            RankerTable rankers(segmentText, RankerTable::Backend::Table);
+            rankers.buildRankerTables();
+
+            padTo(out, records[s].xCellsOffset);
+            writeCells(out, cells, [&](size_t from, size_t count, uint32_t* buffer) {
+                rankers.copyXCells(from, count, buffer);
+            });
+            padTo(out, records[s].yCellsOffset);
+            writeCells(out, cells, [&](size_t from, size_t count, uint32_t* buffer) {
+                rankers.copyYCells(from, count, buffer);
+            });
+        }
+
+        // X-tree parent is the max X-rank over the alphabet, Y-tree parent the min Y-rank
+        vector<int32_t> xParents = XYTree::computeXParents(segmentText, symbols);
+        xParents.push_back(INF);  // prnt(n) is the root
+        vector<int32_t> yParents = XYTree::computeYParents(segmentText, symbols);  // prnt(0) is the root
+
+        padTo(out, records[s].xParentsOffset);
+        writeArray(out, xParents);
+        padTo(out, records[s].yParentsOffset);
+        writeArray(out, yParents);
+    }
+    padTo(out, offset);
+
+    if (!out) throw runtime_error("TextIndex: failed writing " + path);
+}
+
+TextIndex::TextIndex(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw runtime_error("TextIndex: cannot open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        throw runtime_error("TextIndex: " + path + " is not an index file");
+    }
+    size = st.st_size;
+
+    data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // the mapping stays valid
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        throw runtime_error("TextIndex: cannot map " + path);
+    }
+
+    const Header& header = *static_cast<const Header*>(data);
+    bool valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.alphabetSize > 0 &&
+                 header.alphabetSize < NOT_IN_ALPHABET &&
+                 header.textLength < static_cast<uint64_t>(numeric_limits<int32_t>::max()) &&
+                 fits(header.segmentsOffset, header.segmentCount, sizeof(TextIndexSegment), size) &&
+                 fits(header.textOffset, header.textLength, 1, size);
+    if (valid && header.version != VERSION) {
+        uint32_t version = header.version;  // read before unmapping
+        munmap(data, size);
+        data = nullptr;
+        throw runtime_error("TextIndex: " + path + " has version " + to_string(version) + ", expected " +
+                            to_string(VERSION));
+    }
+    const uint8_t* encoded = static_cast<const uint8_t*>(at(header.textOffset));
+    for (uint64_t s = 0; valid && s < header.segmentCount; s++) {
+        const TextIndexSegment& segment =
+            static_cast<const TextIndexSegment*>(at(header.segmentsOffset))[s];
+        valid = segment.start >= 0 && segment.start < segment.end &&
+                static_cast<uint64_t>(segment.end) <= header.textLength;
+        if (!valid) break;
+
+        // every section of the segment lies inside the file, and its text decodes within the alphabet
+        uint64_t length = segment.end - segment.start;
+        uint64_t cells = (length + 1) * header.alphabetSize;
+        valid = fits(segment.xCellsOffset, cells, sizeof(uint32_t), size) &&
+                fits(segment.yCellsOffset, cells, sizeof(uint32_t), size) &&
+                fits(segment.xParentsOffset, length + 1, sizeof(int32_t), size) &&
+                fits(segment.yParentsOffset, length + 1, sizeof(int32_t), size) &&
+                all_of(encoded + segment.start, encoded + segment.end,
+                    [&](uint8_t value) { return value < header.alphabetSize; });
+    }
+    if (!valid) {
+        munmap(data, size);
+        data = nullptr;
+        throw runtime_error("TextIndex: " + path + " is not an index file");
+    }
+
+    alphabet.assign(header.alphabet, header.alphabetSize);
+}
+
+TextIndex::~TextIndex() {
+    if (data != nullptr) munmap(data, size);
+}
+
+const void* TextIndex::at(uint64_t offset) const { return static_cast<const char*>(data) + offset; }
+
+const TextIndexSegment& TextIndex::record(int s) const {
+    const Header& header = *static_cast<const Header*>(data);
+    return static_cast<const TextIndexSegment*>(at(header.segmentsOffset))[s];
+}
+
+int TextIndex::textLength() const { return static_cast<const Header*>(data)->textLength; }
+
+int TextIndex::segmentCount() const { return static_cast<const Header*>(data)->segmentCount; }
+
+Interval TextIndex::segment(int s) const { return Interval(record(s).start, record(s).end); }
+
+string TextIndex::segmentText(int s) const {
+    const uint8_t* encoded = static_cast<const uint8_t*>(at(static_cast<const Header*>(data)->textOffset));
+
+    string text(record(s).end - record(s).start, '\0');
+    for (size_t i = 0; i < text.size(); i++) {
+        text[i] = alphabet[encoded[record(s).start + i]];
+    }
+    return text;
+}
+
+RankerTable TextIndex::rankers(int s) const {
+    return RankerTable(segmentText(s),
+        static_cast<const uint32_t*>(at(record(s).xCellsOffset)),
+        static_cast<const uint32_t*>(at(record(s).yCellsOffset)));
+}
+
+const int32_t* TextIndex::xTreeParents(int s) const {
+    return static_cast<const int32_t*>(at(record(s).xParentsOffset));
+}
+
+const int32_t* TextIndex::yTreeParents(int s) const {
+    return static_cast<const int32_t*>(at(record(s).yParentsOffset));
+}
@@ -1,13 +1,222 @@
 #include "data/XYTree.h"
 
 #include <iostream>
+#include <thread>
 
+#include "utils/Alphabet.h"
 #include "utils/Common.h"
+#include "utils/Parallel.h"
+#include "utils/SymbolMask.h"
 
 using namespace std;
 using namespace XYTree;
 
-Node::Node(int index) : index(index) {};
+namespace {
+    // Symbols ordered by their latest occurrence in a scan, most recent first (a doubly linked list over
+    // dense alphabet indexes). The least recent one is the symbol that completes the shortest arch.
+    struct RecencyList {
+        vector<int> before, after;  // neighbours towards the head / tail, -1 at the ends
+        int head = -1;
+        int tail = -1;
+
+        explicit RecencyList(int width) : before(width, -1), after(width, -1) {}
+
+        void unlink(int c) {
+            (before[c] == -1 ? head : after[before[c]]) = after[c];
+            (after[c] == -1 ? tail : before[after[c]]) = before[c];
+        }
+
+        void pushFront(int c) {
+            before[c] = -1;
+            after[c] = head;
+            (head == -1 ? tail : before[head]) = c;
+            head = c;
+        }
+    };
+
+    /**
+     * @brief Lines 11-17 of the X-tree construction: r of the node at position `parent`, with s_p = blocks[first, ...).
+     *
+     * Only the peeked block is ever modified, so s'_p is the peeked block index plus a copy of that block.
+     * Reads nothing but the ranker and the blocks, so nodes can be processed in any order and in parallel.
+     */
+    int computeXR(const RankerTable& ranker, const vector<SymbolMask>& blocks, int first, int parent) {
+        int block_count = blocks.size();
+
+        // line 11: s'_p <- copy(s_p)
+        int block = first;
+        SymbolMask S = block < block_count ? blocks[block] : SymbolMask();
+
+        // line 12: T_X(T).r(parent) <- parent : 논문에선 parent 대신 i로 써있는데, parent가 맞는 것으로 결론지음.
+        int r = parent;
+
+        // line 13: while s'_p is not empty
+        while (block < block_count) {
+            // line 14-15: sigma = arg min_{c in peek(s'_p)} (R_X(T, T_X(T).r(parent), c))
+            int min_x_rank = INF;
+            int sigma = S.first();
+            S.forEach([&](int c) {
+                int x_rank = ranker.getXByIndex(r, c);
+                if (x_rank < min_x_rank) {
+                    min_x_rank = x_rank;
+                    sigma = c;
+                }
+            });
+
+            // line 16: T_X(T).r(parent) <- R_X(T, T_X(T).r(parent), sigma)
+            r = min_x_rank;
+            if (r == INF) return parent;
+
+            // line 17: pop sigma from s'_p
+            S.reset(sigma);
+            if (S.empty() && ++block < block_count) {
+                S = blocks[block];
+            }
+        }
+        return r;
+    }
+
+    /**
+     * @brief Lines 11-17 of the Y-tree construction: r of the node at position `parent`, with s_p = blocks[0, last].
+     */
+    int computeYR(const RankerTable& ranker, const vector<SymbolMask>& blocks, int last, int parent) {
+        // line 11: s'_p <- copy(s_p)
+        int block = last;
+        SymbolMask S = block >= 0 ? blocks[block] : SymbolMask();
+
+        // line 12: T_Y(T).r(parent) <- parent : 논문에선 parent 대신 i로 써있는데, parent가 맞는 것으로 결론지음.
+        int r = parent;
+
+        // line 13: while s'_p is not empty
+        while (block >= 0) {
+            // line 14-15: sigma = arg max_{c in peek(s'_p)} (R_Y(T, r(i), c))
+            int max_y_rank = -1;
+            int sigma = S.first();
+            S.forEach([&](int c) {
+                int y_rank = ranker.getYByIndex(r, c);
+                if (y_rank > max_y_rank) {
+                    max_y_rank = y_rank;
+                    sigma = c;
+                }
+            });
+
+            // line 16: T_Y(T).r(i) <- R_Y(T, T_Y(T).r(i), sigma)
+            r = max_y_rank;
+            if (r < 0) return parent;
+
+            // line 17: pop sigma from s'_p
+            S.reset(sigma);
+            if (S.empty() && --block >= 0) {
+                S = blocks[block];
+            }
+        }
+        return r;
+    }
+}  // namespace
+
+/**
+ * @brief Scans right-to-left keeping the symbols ordered by next occurrence.
+ * Once every symbol has occurred, prnt(i) is the next occurrence (+1) of the least recent one.
+ */
+vector<int32_t> XYTree::computeXParents(const string& text, const SymbolMask& symbols) {
+    int n = text.size();
+    int total = symbols.count();
+    vector<int32_t> parents(n, total == 0 ? -1 : INF);  // max over an empty set is -1, as in RankerTable::maxX
+    if (total == 0) return parents;
+
+    RecencyList order(Alphabet::getInstance().size());
+    vector<int32_t> next(Alphabet::getInstance().size(), INF);
+    int seen = 0;
+    for (int i = n - 1; i >= 0; i--) {
+        int c = Alphabet::getInstance().charToIndex(text[i]);
+        if (symbols.test(c)) {
+            if (next[c] == INF)
+                seen++;
+            else
+                order.unlink(c);
+            order.pushFront(c);
+            next[c] = i + 1;
+        }
+        if (seen == total) parents[i] = next[order.tail];
+    }
+    return parents;
+}
+
+/**
+ * @brief Scans left-to-right keeping the symbols ordered by previous occurrence.
+ * Once every symbol has occurred, prnt(i) is the previous occurrence of the least recent one.
+ */
+vector<int32_t> XYTree::computeYParents(const string& text, const SymbolMask& symbols) {
+    int n = text.size();
+    int total = symbols.count();
+    vector<int32_t> parents(n + 1, total == 0 ? INF : -1);  // min over an empty set is INF, as in RankerTable::minY
+    parents[0] = -1;
+    if (total == 0) return parents;
+
+    RecencyList order(Alphabet::getInstance().size());
+    vector<int32_t> prev(Alphabet::getInstance().size(), -1);
+    int seen = 0;
+    for (int i = 0; i < n; i++) {
+        int c = Alphabet::getInstance().charToIndex(text[i]);
+        if (symbols.test(c)) {
+            if (prev[c] == -1)
+                seen++;
+            else
+                order.unlink(c);
+            order.pushFront(c);
+            prev[c] = i;
+        }
+        if (seen == total) parents[i + 1] = prev[order.tail];
+    }
+    return parents;
+}
+
+/**
+ * @brief Builds the binary lifting table for walks of up to maxSteps edges.
+ *
+ * jump[0] is the parent array, jump[l][v] = jump[l-1][jump[l-1][v]]. The root is its own parent.
+ */
+void XYTree::Tree::buildAncestors(int maxSteps) {
+    int levels = 0;
+    while ((1 << levels) <= maxSteps) levels++;
+
+    jump.assign(levels, vector<int32_t>());
+    if (levels == 0) return;
+
+    jump[0] = parent;
+    for (int l = 1; l < levels; l++) {
+        jump[l].resize(nodeCount());
+        for (int v = 0; v < nodeCount(); v++) {
+            jump[l][v] = jump[l - 1][jump[l - 1][v]];
+        }
+    }
+}
+
+/**
+ * @brief Level-ancestor query: same node as stepping to the parent `steps` times, breaking once the root is
+ * reached. Distances beyond the built levels are covered by repeating the top level.
+ */
+int32_t XYTree::Tree::ancestor(int32_t node, int steps, vector<int>* path) const {
+    if (path != nullptr) {
+        for (int i = 0; i < steps && node != ROOT; i++) {
+            node = parent[node];
+            path->push_back(index[node]);
+        }
+        return node;
+    }
+
+    while (steps > 0 && node != ROOT) {
+        if (jump.empty()) {
+            node = parent[node];
+            steps--;
+            continue;
+        }
+        int level = min(static_cast<int>(jump.size()) - 1, 31 - __builtin_clz(steps));
+        node = jump[level][node];
+        steps -= 1 << level;
+    }
+    return node;
+}
 
 /**
  * @brief X-Tree Construction given precomputed components.
@@ -15,116 +224,92 @@ Node::Node(int index) : index(index) {};
  * @param ranker Prebuilt ranker table
  * @param shortlex Precomputed `ShortlexResult` of a pattern string
  * @param text Text.
+ * @param parents Precomputed prnt(i) for every i, or nullptr to compute them.
+ * @param mode How prnt(i) is computed when parents is nullptr.
+ * @param threads Threads computing the r values of the nodes (0 = hardware concurrency).
  * @return `XYTree::Tree` the constructed X-tree.
  */
-XYTree::Tree XYTree::buildXTree(const RankerTable& ranker, const ShortlexResult& shortlex, const string& text) {
+XYTree::Tree XYTree::buildXTree(const RankerTable& ranker,
+    const ShortlexResult& shortlex,
+    const string& text,
+    const int32_t* parents,
+    ParentMode mode,
+    int threads) {
     XYTree::Tree tree;
+    int n = text.size();
 
-    shared_ptr<Node> root = make_shared<Node>(INF);
-    tree.root = root;
-    tree.parent = vector<shared_ptr<Node>>(text.size() + 1);
-
-    unordered_map<int, shared_ptr<Node>> nodes;
-    nodes[INF] = root;
+    // root: its children are the suffix of positions with prnt() = INF, set once the first one shows up
+    tree.index.push_back(INF);
+    tree.r.push_back(INF);
+    tree.children.emplace_back(n, n - 1);
+    tree.parent.push_back(ROOT);
+    tree.nodeAt.assign(n + 1, NO_NODE);
 
     debug(cout << "Building X-tree..." << endl);
 
-    //) Copy out s_p
-    deque<set<char>> s_p;
-    set<char> s;
-    for (int i = 0; i < shortlex.stackForm.size(); i++) {
-        debug(cout << "i: " << i << ", pushing s which consists of: " << endl);
-        s = shortlex.stackForm.at(i);
-        s_p.push_back(s);
-        debug(for(auto a: s){ cout << a << " "; } cout << endl);
-    }
+    // s_p is read from its bottom block (the start of the SNF) upward: s_p = blocks[first, blocks.size())
+    const vector<SymbolMask>& blocks = shortlex.stackMasks;
+    int block_count = blocks.size();
+    int alphabet_size = shortlex.alphabet.size();
 
     // ln 4-6
-    set<char> deleted_chars;
+    int first = 0;
     for (int i = 0; i < shortlex.universality; i++) {
-        while (deleted_chars.size() < shortlex.alphabet.size()) {
-            for(auto a: s_p.back()) deleted_chars.insert(a);
-            s_p.pop_back();
+        SymbolMask deleted_chars;
+        while (deleted_chars.count() < alphabet_size && first < block_count) {
+            deleted_chars |= blocks[first++];
         }
-        deleted_chars.clear();
     }
-    debug(cout << "s_p is left with: " << endl);
-    debug(for(auto ss: s_p){ for(auto a: ss){ cout << a << endl; } } cout << endl);
+    debug(cout << "s_p is left with " << block_count - first << " blocks" << endl);
+
+    // ln 8: prnt(i) = max_{a in alph(p)} R_X(T, i, a), for all i at once
+    vector<int32_t> computed_parents;
+    if (parents == nullptr) {
+        if (mode == ParentMode::Scan) {
+            computed_parents = computeXParents(text, SymbolMask::fromChars(shortlex.alphabet));
+        } else {
+            computed_parents.resize(text.size());
+            ranker.maxX(0, text.size(), SymbolMask::fromChars(shortlex.alphabet), computed_parents.data());
+        }
+        parents = computed_parents.data();
+    }
 
     // ln 7-21
-    deque<set<char>> sp_p;
-    set<char> S;
-    shared_ptr<Node> last_node = root;
-    for (int i = 0; i < static_cast<int>(text.size()); i++) {
-        int parent = -1;
-        int x_rank;
-        for (char a : shortlex.alphabet) {
-            x_rank = ranker.getX(i, a);
-            if (x_rank > parent) parent = x_rank;
-        }
+    for (int i = 0; i < n; i++) {
+        int parent = parents[i];
+        int32_t parent_node = parent == INF ? ROOT : tree.nodeAt[parent];
 
         // ln 9-18
-        if (nodes.count(parent) == 0) {
-            shared_ptr<Node> parent_node = make_shared<Node>(parent);
-            nodes[parent] = parent_node;
-            debug(cout << "Generate new node " << *parent_node << endl);
-            last_node->next = parent_node;
-            last_node = parent_node;
-
-            // line 11: s'_p <- copy(s_p)
-            sp_p.clear();
-            for (auto entry = s_p.begin(); entry != s_p.end(); entry++) {
-                sp_p.push_back(*entry);
-            }
-
-            // line 12: T_X(T).r(parent) <- parent : 논문에선 parent 대신 i로 써있는데, parent가 맞는 것으로 결론지음.
-            parent_node->r = parent;
-
-            // line 13: while s'_p is not empty
-            while (!sp_p.empty()) {
-                // line 14: S <- peek(s'_p)
-                S = sp_p.back();
-
-                // line 15: sigma = arg min (R_X(T, T_X(T).r(parent), c))
-                int min_x_rank = -1;
-                char sigma;
-                for (char c : S) {
-                    x_rank = ranker.getX(parent_node->r, c);
-                    if (min_x_rank == -1 || x_rank < min_x_rank) {
-                        min_x_rank = x_rank;
-                        sigma = c;
-                    }
-                }
-
-                // line 16: T_X(T).r(parent) <- R_X(T, T_X(T).r(parent), sigma)
-                parent_node->r = ranker.getX(parent_node->r, sigma);
-                if (parent_node->r == INF) {
-                    parent_node->r = parent;
-                    break;
-                }
-
-                // line 17: pop sigma from s'_p
-                sp_p.back().erase(sigma);
-                if (sp_p.back().empty()) {
-                    sp_p.pop_back();
-                }
-            }
+        if (parent_node == NO_NODE) {
+            parent_node = tree.nodeCount();
+            tree.nodeAt[parent] = parent_node;
+            tree.index.push_back(parent);
+            tree.r.push_back(parent);  // set below
+            tree.children.emplace_back();
+            tree.parent.push_back(ROOT);  // set below, once prnt(parent) is known
+            debug(cout << "Generate new node " << describe(tree, parent_node) << endl);
 
             // line 18: T_X(T).chld(parent) <- [i, i]   // 논문에서는 [i, i)지만 편의상 [i, i]를 쓰기로
-            parent_node->children = Interval(i, i - 1);  // line 19 에서 [i, i]로 바뀔 것
+            tree.children[parent_node] = Interval(i, i - 1);  // line 19 에서 [i, i]로 바뀔 것
+        } else if (parent_node == ROOT && tree.children[ROOT].start > tree.children[ROOT].end) {
+            tree.children[ROOT] = Interval(i, i - 1);
         }
 
         // line 19: extend end point of T_X(`T`).chld(parent) by one
-        nodes[parent]->children.end++;
-
-        // line 21: T_X(T).prnt(i) <- parent (Note: 논문의 Algorithm 1 에서는 i가 Nodes에 포함인 경우에만 하도록 되어있지만, 6페이지에 모든 i에 대하여 prnt(i)가 작동하도록 하게끔 abuse한다는 내용이 있음)
-        tree.parent[i] = nodes[parent];
-        debug(cout << "Set parent of " << i << " to " << *nodes[parent] << endl);
+        tree.children[parent_node].end++;
+        debug(cout << "Set parent of " << i << " to " << describe(tree, parent_node) << endl);
     }
 
-    // Clean up
-    last_node->next = root;
-    tree.parent[text.size()] = root;
+    // lines 11-17 for every node, independent of each other
+    parallelFor(1, tree.nodeCount(), threads, [&](int node) {
+        tree.r[node] = computeXR(ranker, blocks, first, tree.index[node]);
+    });
+
+    // line 21: T_X(T).prnt(i) <- parent, kept for nodes only (prnt(n) is the root)
+    for (int32_t node = 1; node < tree.nodeCount(); node++) {
+        int index = tree.index[node];
+        tree.parent[node] = (index == n || parents[index] == INF) ? ROOT : tree.nodeAt[parents[index]];
+    }
 
     debug(cout << "End of X-tree construction" << endl << endl);
     return tree;
@@ -136,118 +321,122 @@ XYTree::Tree XYTree::buildXTree(const RankerTable& ranker, const ShortlexResult&
  * @param ranker Prebuilt ranker table
  * @param shortlex Precomputed `ShortlexResult` of a pattern string
  * @param text Text.
+ * @param parents Precomputed prnt(i) for every i, or nullptr to compute them.
+ * @param mode How prnt(i) is computed when parents is nullptr.
+ * @param threads Threads computing the r values of the nodes (0 = hardware concurrency).
  * @return `XYTree::Tree` the constructed Y-tree.
  */
-XYTree::Tree XYTree::buildYTree(const RankerTable& ranker, const ShortlexResult& shortlex, const string& text) {
+XYTree::Tree XYTree::buildYTree(const RankerTable& ranker,
+    const ShortlexResult& shortlex,
+    const string& text,
+    const int32_t* parents,
+    ParentMode mode,
+    int threads) {
     XYTree::Tree tree;
+    int n = text.size();
 
-    shared_ptr<Node> root = make_shared<Node>(-1);
-    tree.root = root;
-    tree.parent = vector<shared_ptr<Node>>(text.size() + 1);
-
-    unordered_map<int, shared_ptr<Node>> nodes;
-    nodes[-1] = root;
+    // root: its children are the prefix of positions with prnt() = -1, set once the last one shows up
+    tree.index.push_back(-1);
+    tree.r.push_back(-1);
+    tree.children.emplace_back(1, 0);
+    tree.parent.push_back(ROOT);
+    tree.nodeAt.assign(n + 1, NO_NODE);
+    tree.positionParent.assign(n + 1, ROOT);  // prnt(0) is the root
 
     debug(cout << "Building Y-tree..." << endl);
 
-    // Copy out s_p (in reverse order) << not sure if reversing is mandatory
-    vector<set<char>> s_p;
-    set<char> s;
-    for (int i = 0; i < shortlex.stackForm.size(); i++) {
-        debug(cout << "i: " << i << ", pushing s which consists of: " << endl);
-        s = shortlex.stackForm.at(shortlex.stackForm.size() - i - 1);
-        s_p.push_back(s);
-        debug(for(auto a: s){ cout << a << " "; } cout << endl);
-    }
+    // s_p is read from its top block (the end of the SNF) downward: s_p = blocks[0, last]
+    const vector<SymbolMask>& blocks = shortlex.stackMasks;
+    int alphabet_size = shortlex.alphabet.size();
 
     // ln 4-6 (Slight rework as well)
-    set<char> deleted_chars;
+    int last = static_cast<int>(blocks.size()) - 1;
     for (int i = 0; i < shortlex.universality; i++) {
-        while (deleted_chars.size() < shortlex.alphabet.size()) {
-            for(auto a: s_p.back()) deleted_chars.insert(a);
-            s_p.pop_back();
+        SymbolMask deleted_chars;
+        while (deleted_chars.count() < alphabet_size && last >= 0) {
+            deleted_chars |= blocks[last--];
         }
-        deleted_chars.clear();
     }
-    debug(cout << "s_p is left with: " << endl);
-    debug(for(auto ss: s_p){ for(auto a: ss){ cout << a << endl; } } cout << endl);
-
-    // ln 7-21
-    vector<set<char>> sp_p;
-    set<char> S;
-    shared_ptr<Node> last_node = root;
-    for (int i = static_cast<int>(text.size()); i > 0; i--) {
-        int parent = INF;
-        int y_rank;
-        for (auto a : shortlex.alphabet) {
-            y_rank = ranker.getY(i, a);
-            if (y_rank < parent) parent = y_rank;
+    debug(cout << "s_p is left with " << last + 1 << " blocks" << endl);
+
+    // ln 8: prnt(i) = min_{a in alph(p)} R_Y(T, i, a), for all i at once
+    vector<int32_t> computed_parents;
+    if (parents == nullptr) {
+        if (mode == ParentMode::Scan) {
+            computed_parents = computeYParents(text, SymbolMask::fromChars(shortlex.alphabet));
+        } else {
+            computed_parents.resize(text.size() + 1);
+            ranker.minY(1, text.size() + 1, SymbolMask::fromChars(shortlex.alphabet), computed_parents.data() + 1);
         }
+        parents = computed_parents.data();
+    }
 
+    // ln 7-21
+    for (int i = n; i > 0; i--) {
+        int parent = parents[i];
+        int32_t parent_node = parent < 0 ? ROOT : tree.nodeAt[parent];
 
         // ln 9-18
-        if (nodes.count(parent) == 0) {
-            shared_ptr<Node> parent_node = make_shared<Node>(parent);
-            nodes[parent] = parent_node;
-            debug(cout << "Generate new node " << *parent_node << endl);
-            last_node->next = parent_node;
-            last_node = parent_node;
-
-            // line 11: s'_p <- copy(s_p)
-            sp_p.clear();
-            for (auto entry = s_p.begin(); entry != s_p.end(); entry++) {
-                sp_p.push_back(*entry);
-            }
-
-            // line 12: T_Y(T).r(parent) <- parent : 논문에선 parent 대신 i로 써있는데, parent가 맞는 것으로 결론지음.
-            parent_node->r = parent;
-
-            // line 13: while s'_p is not empty
-            while (!sp_p.empty()) {
-                // line 14: S <- peek(s'_p)
-                S = sp_p.back();
-
-                // line 15: sigma = arg min (R_Y(T, r(i), c))
-                int max_y_rank = INF;
-                char sigma;
-                for (char c : S) {
-                    y_rank = ranker.getY(parent_node->r, c);
-                    if (max_y_rank == INF || y_rank > max_y_rank) {
-                        max_y_rank = y_rank;
-                        sigma = c;
-                    }
-                }
-
-                // line 16: T_Y(T).r(i) <- R_Y(T, T_Y(T).r(i), sigma)
-                parent_node->r = ranker.getY(parent_node->r, sigma);
-                if (parent_node->r < 0) {
-                    parent_node->r = parent;
-                    break;
-                }
-
-                // line 17: pop sigma from s'_p
-                sp_p.back().erase(sigma);
-                if (sp_p.back().empty()) {
-                    sp_p.pop_back();
-                }
-            }
+        if (parent_node == NO_NODE) {
+            parent_node = tree.nodeCount();
+            tree.nodeAt[parent] = parent_node;
+            tree.index.push_back(parent);
+            tree.r.push_back(parent);  // set below
+            tree.children.emplace_back();
+            tree.parent.push_back(ROOT);  // set below, once prnt(parent) is known
+            debug(cout << "Generate new node " << describe(tree, parent_node) << endl);
 
             // line 18: T_Y(T).chld(parent) <- [i, i]   // 논문에서는 [i, i)지만 편의상 [i, i]를 쓰기로
-            parent_node->children = Interval(i + 1, i);  // line 19 에서 [i, i]로 바뀔 것
+            tree.children[parent_node] = Interval(i + 1, i);  // line 19 에서 [i, i]로 바뀔 것
+        } else if (parent_node == ROOT && tree.children[ROOT].start > tree.children[ROOT].end) {
+            tree.children[ROOT] = Interval(i + 1, i);
         }
 
         // line 19: extend end point of T_Y(T).chld(parent) by one
-        nodes[parent]->children.start--;
+        tree.children[parent_node].start--;
 
         // line 21: T_Y(T).prnt(i) <- parent (Note: 논문의 Algorithm 1 에서는 i가 Nodes에 포함인 경우에만 하도록 되어있지만, 6페이지에 모든 i에 대하여 prnt(i)가 작동하도록 하게끔 abuse한다는 내용이 있음)
-        tree.parent[i] = nodes[parent];
-        debug(cout << "Set parent of " << i << " to " << *nodes[parent] << endl);
+        tree.positionParent[i] = parent_node;
+        debug(cout << "Set parent of " << i << " to " << describe(tree, parent_node) << endl);
     }
 
-    // Clean up
-    last_node->next = root;
-    tree.parent[0] = root;
+    // lines 11-17 for every node, independent of each other
+    parallelFor(1, tree.nodeCount(), threads, [&](int node) {
+        tree.r[node] = computeYR(ranker, blocks, last, tree.index[node]);
+    });
+
+    // node-level parents (prnt(0) is the root)
+    for (int32_t node = 1; node < tree.nodeCount(); node++) {
+        tree.parent[node] = tree.positionParent[tree.index[node]];
+    }
 
     debug(cout << "End of Y-tree construction" << endl << endl);
     return tree;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Builds both trees from the same ranker. The builders only read the ranker and the ShortlexResult,
+ * so they run on two threads, each computing its r values with half of the threads.
+ */
+pair<XYTree::Tree, XYTree::Tree> XYTree::buildXYTrees(const RankerTable& ranker,
+    const ShortlexResult& shortlex,
+    const string& text,
+    int threads,
+    const int32_t* xParents,
+    const int32_t* yParents) {
+    if (threads <= 0) threads = defaultThreadCount();
+
+    pair<Tree, Tree> trees;
+    if (threads == 1 || static_cast<int>(text.size()) < PARALLEL_MIN_LENGTH) {
+        trees.first = buildXTree(ranker, shortlex, text, xParents);
+        trees.second = buildYTree(ranker, shortlex, text, yParents);
+        return trees;
+    }
+
+    thread yBuilder([&] {
+        trees.second = buildYTree(ranker, shortlex, text, yParents, ParentMode::Scan, threads / 2);
+    });
+    trees.first = buildXTree(ranker, shortlex, text, xParents, ParentMode::Scan, threads - threads / 2);
+    yBuilder.join();
+    return trees;
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "data/MatchSimK.h"
+#include "data/TextIndex.h"
+#include "utils/Common.h"
+
+using namespace std;
+
+// ------------------
+// Runs MatchSimK on a TextIndex file built by build_text_index
+// ------------------
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        cerr << "You must enter an index file, a pattern and k" << endl;
+        cerr << "Usage: " << argv[0] << " <index-file-name> <pattern> <k>" << endl;
+        return 1;
+    }
+
+    string pattern = argv[2];
+    int k = stoi(argv[3]);
+
+    try {
+        TextIndex index(argv[1]);
+
+        cout << "pattern: " << pattern << endl;
+        cout << "k: " << k << endl;
+
+        vector<MatchSimK::triple> positions = MatchSimK::matchSimK(index, pattern, k);
+
+        cout << endl << "returned positions:" << endl;
+        for (MatchSimK::triple position : positions) {
+            cout << get<0>(position) << ", " << get<1>(position) << ", offset=" << get<2>(position) << endl;
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,33 +1,76 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
 #include <iostream>
+#include <string>
 
 #include "data/SimonTree.h"
 
 using namespace SimonTree;
 
+// Streams the file from its end in fixed-size chunks (whitespace skipped, as in the interactive mode) and prints
+// statistics of its Simon tree without keeping the tree in memory
+int streamStatistics(const string& path) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        cerr << "Cannot open " << path << endl;
+        return 1;
+    }
+    file.seekg(0, ios::end);
+    streamoff remaining = file.tellg();
+
+    int64_t leaves = 0;
+    int64_t height = 0;
+    TreeBuilder builder([&](const TreeBuilder::ClosedNode& node) {
+        if (node.firstChild == NO_NODE) leaves++;
+        height = max(height, node.depth);
+    });
+
+    const streamoff CHUNK = 1 << 20;
+    string chunk, letters;
+    while (remaining > 0) {
+        streamoff size = min(CHUNK, remaining);
+        remaining -= size;
+        chunk.resize(size);
+        file.seekg(remaining);
+        file.read(&chunk[0], size);
+
+        letters.clear();
+        for (char c : chunk) {
+            if (!isspace(static_cast<unsigned char>(c))) letters += c;
+        }
+        builder.pushFront(letters);
+    }
+    builder.finish();
+
+    cout << "letters: " << builder.length() << "\n";
+    cout << "nodes:   " << builder.nodeCount() << "\n";
+    cout << "leaves:  " << leaves << "\n";
+    cout << "height:  " << height << "\n";
+    return 0;
+}
+
 // ------------------
 // A simple test driver for SimonTree.cpp
+// Usage: ./bin/simon_tree [--json]
+//        ./bin/simon_tree --file <path>
 // ------------------
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && string(argv[1]) == "--file") return streamStatistics(argv[2]);
+    bool json = argc >= 2 && string(argv[1]) == "--json";
+
     string w;
-    cout << "Enter the word: ";
+    if (!json) cout << "Enter the word: ";
     cin >> w;
 
-    int n = w.size();
-    string wp = w + "$";
-    vector<int> X = computeX(w);
+    Tree tree = buildTree(w);
 
-    auto root = make_shared<Node>(-1, n + 1, 0);
-    shared_ptr<Node> p = root;
-
-    for (int i = n; i >= 1; --i) {
-        auto a = findNode(i, X, p);
-        tie(root, p) = splitNode(i, root, a);
+    if (json) {
+        writeTreeJson(tree);
+    } else {
+        cout << "\n Constructed Simon-Tree:\n\n";
+        printTree(tree, w);
     }
 
-    fixTree(root, n);
-
-    cout << "\n Constructed Simon-Tree:\n\n";
-    printTree(root, w);
-
     return 0;
-}
\ No newline at end of file
+}
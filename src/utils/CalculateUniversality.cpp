@@ -0,0 +1,196 @@
+#include "utils/CalculateUniversality.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+#include "utils/Alphabet.h"
+#include "utils/Parallel.h"
+#include "utils/SymbolMask.h"
+
+using namespace std;
+
+namespace {
+    // Inputs shorter than this are factorized serially
+    constexpr int PARALLEL_MIN_LENGTH = 1 << 16;
+
+    // Symbols seen since the last arch end, for alphabets of up to 64 symbols: the arch is complete once the
+    // word is full
+    struct WordState {
+        uint64_t seen = 0;
+        uint64_t full;
+
+        explicit WordState(int total) : full(total == 64 ? ~uint64_t(0) : (uint64_t(1) << total) - 1) {}
+
+        bool empty() const { return seen == 0; }
+
+        // Adds symbol c, returns true (and starts the next arch) if that completes the arch
+        bool add(int c) {
+            seen |= uint64_t(1) << c;
+            if (seen != full) return false;
+            seen = 0;
+            return true;
+        }
+    };
+
+    // Same for larger alphabets, over a multiword mask with a count of its bits
+    struct MaskState {
+        SymbolMask seen;
+        int count = 0;
+        int total;
+
+        explicit MaskState(int total) : total(total) {}
+
+        bool empty() const { return count == 0; }
+
+        bool add(int c) {
+            count += !seen.test(c);  // branch-free: whether c is new is hard to predict inside an arch
+            seen.set(c);
+            if (count != total) return false;
+            seen = SymbolMask();
+            count = 0;
+            return true;
+        }
+    };
+
+    enum class ScanEnd { Done, Converged };
+
+    [[noreturn]] void throwInvalid() { throw out_of_range("Alphabet: char is not in the alphabet"); }
+
+    /**
+     * @brief Extends the factorization over text[from, to) from `state`, appending arch ends to `ends`.
+     * Stops with Converged right after an arch end for which converged(end) holds, and throws at a char outside
+     * the alphabet.
+     */
+    template <typename State, typename Converged>
+    ScanEnd scanArches(const array<int, 256>& index,
+        string_view text,
+        int from,
+        int to,
+        State& state,
+        vector<int>& ends,
+        Converged converged) {
+        State local = state;  // kept out of memory that `ends` might alias
+        ScanEnd result = ScanEnd::Done;
+        for (int i = from; i < to; i++) {
+            int c = index[static_cast<unsigned char>(text[i])];
+            if (c < 0) throwInvalid();
+            if (local.add(c)) {
+                ends.push_back(i);
+                if (converged(i)) {
+                    result = ScanEnd::Converged;
+                    break;
+                }
+            }
+        }
+        state = local;
+        return result;
+    }
+
+    template <typename State>
+    vector<int> factorize(const array<int, 256>& index, int total, string_view text, int threads) {
+        int n = text.size();
+        auto never = [](int) { return false; };
+        vector<int> ends;
+        if (threads == 1 || n < PARALLEL_MIN_LENGTH) {
+            State state(total);
+            scanArches(index, text, 0, n, state, ends, never);
+            return ends;
+        }
+
+        // 1. speculative factorization of every chunk, starting a fresh arch at its first char
+        int chunks = max(1, min(threads, n));
+        vector<int> chunkBegin(chunks + 1);
+        vector<vector<int>> chunkEnds(chunks);
+        vector<State> chunkState(chunks, State(total));  // state at the chunk end
+        parallelChunks(0, n, threads, [&](int begin, int end, int chunk) {
+            chunkBegin[chunk] = begin;
+            chunkBegin[chunk + 1] = end;
+            scanArches(index, text, begin, end, chunkState[chunk], chunkEnds[chunk], never);
+        });
+
+        // 2. fix-up: rescan each chunk from the true state until an arch end meets a speculative one, then the
+        // speculative arch ends and end state hold for the rest of the chunk
+        State state(total);
+        for (int chunk = 0; chunk < chunks; chunk++) {
+            const vector<int>& speculative = chunkEnds[chunk];
+            size_t next = 0;  // first speculative arch end not yet passed
+            bool converged = state.empty();
+            if (!converged) {
+                auto meets = [&](int end) {
+                    while (next < speculative.size() && speculative[next] < end) next++;
+                    if (next < speculative.size() && speculative[next] == end) {
+                        next++;
+                        return true;
+                    }
+                    return false;
+                };
+                converged = scanArches(index, text, chunkBegin[chunk], chunkBegin[chunk + 1], state, ends, meets) ==
+                            ScanEnd::Converged;
+            }
+            if (converged) {
+                ends.insert(ends.end(), speculative.begin() + next, speculative.end());
+                state = chunkState[chunk];
+            }
+        }
+        return ends;
+    }
+
+    template <typename State>
+    void profileFrom(const array<int, 256>& index, int total, string_view text, UniversalityProfile& profile) {
+        int n = text.size();
+        profile.universality.resize(n + 1);
+        profile.universality[n] = 0;
+
+        State state(total);
+        int arches = 0;
+        for (int i = n - 1; i >= 0; i--) {
+            int c = index[static_cast<unsigned char>(text[i])];
+            if (c < 0) throwInvalid();
+            if (state.add(c)) {
+                arches++;
+                profile.archStarts.push_back(i);
+            }
+            profile.universality[i] = arches;
+        }
+        reverse(profile.archStarts.begin(), profile.archStarts.end());
+    }
+
+    // Copy of the alphabet's table, read without going through the singleton per char
+    array<int, 256> alphabetIndex() {
+        string alphabet = Alphabet::getInstance().getAlphabet();
+        array<int, 256> index;
+        index.fill(-1);
+        for (int i = 0; i < static_cast<int>(alphabet.size()); i++) index[static_cast<unsigned char>(alphabet[i])] = i;
+        return index;
+    }
+}  // namespace
+
+vector<int> archFactorization(string_view text, int threads) {
+    int total = Alphabet::getInstance().size();
+    array<int, 256> index = alphabetIndex();
+
+    if (threads <= 0) threads = defaultThreadCount();
+    if (total <= 64) return factorize<WordState>(index, total, text, threads);
+    return factorize<MaskState>(index, total, text, threads);
+}
+
+int calculateUniversalityIndex(const string& text, int threads) { return archFactorization(text, threads).size(); }
+
+UniversalityProfile universalityProfile(string_view text) {
+    int total = Alphabet::getInstance().size();
+    array<int, 256> index = alphabetIndex();
+    UniversalityProfile profile;
+    if (total <= 64)
+        profileFrom<WordState>(index, total, text, profile);
+    else
+        profileFrom<MaskState>(index, total, text, profile);
+    return profile;
+}
+
+vector<UniversalityProfile> universalityProfiles(const vector<string>& texts, int threads) {
+    vector<UniversalityProfile> profiles(texts.size());
+    parallelFor(0, texts.size(), threads, [&](int i) { profiles[i] = universalityProfile(texts[i]); });
+    return profiles;
+}
@@ -18,18 +18,17 @@ void printTree(const Tree& tree) {
     cout << left << setw(10) << "Index" << setw(10) << "Parent"
          << "Children\n";
 
-    for (shared_ptr<XYTree::Node> current_node = tree.root->next; current_node != tree.root;
-        current_node = current_node->next) {
-        int i = current_node->index;
-        cout << left << setw(10) << i;
+    for (int32_t node = 1; node < tree.nodeCount(); node++) {
+        cout << left << setw(10) << tree.index[node];
 
-        if (tree.parent[i]->index == INF) {
+        int parent = tree.index[tree.parent[node]];
+        if (parent == INF) {
             cout << setw(10) << "INF";
         } else {
-            cout << setw(10) << tree.parent[i]->index;
+            cout << setw(10) << parent;
         }
 
-        cout << "[" << current_node->children.start << "," << current_node->children.end << "]";
+        cout << "[" << tree.children[node].start << "," << tree.children[node].end << "]";
 
         cout << endl;
     }